@@ -2,109 +2,597 @@
 #include <cstring>
 #include <memory>
 #include <cmath>
+#include <atomic>
+#include <utility>
+#include <optional>
+#include <functional>
+#include <iterator>
+#include <coroutine>
+#include <array>
+#include <chrono>
+#include <bit>
+#include <cstdint>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 using namespace std;
 
-// An iterator for a cirular before (returned by the begin() and end() methods)
+// cache line size assumed by the padding and buffer alignment below
+constexpr size_t cache_line = 64;
+
+// Unique handle to a ring's storage: the element pointer plus a type-erased
+// teardown. Nothing ever shared a buffer between rings (copies are deep), so
+// the shared_ptr handles used previously paid for a control block allocation
+// and atomic refcounting that bought nothing. The deleter still lets each
+// allocator carry whatever teardown (and captured context) it needs.
+template<class T>
+using ring_storage = unique_ptr<T, function<void(T*)>>;
+
+// Allocates count elements and returns a pointer whose first element sits on
+// a cache line boundary when the element size allows stepping onto one (it
+// always does for power-of-two sized elements). The allocation is one line
+// larger than requested; the deleter remembers the real allocation start.
+// This keeps a ring's first line from being shared with whatever the
+// allocator placed just before it.
+template<class T>
+ring_storage<T> make_cache_aligned(size_t count) {
+    size_t slack = (cache_line + sizeof(T) - 1) / sizeof(T); // elements we may skip
+    T* raw = new T[count + slack];
+    T* first = raw;
+    for (size_t k = 0; k <= slack; ++k) {
+        if ((uintptr_t)(void*)(raw + k) % cache_line == 0) {
+            first = raw + k;
+            break;
+        }
+    }
+    return ring_storage<T>(first, [raw](T*) { delete[] raw; });
+}
+
+// Allocator policies: where a ring's storage comes from. An allocator hands
+// out a ring_storage handle whose deleter knows how to tear the storage down
+// again, so the rings themselves never care which backing they got.
+
+// the default: heap allocation, aligned to a cache line as before
+template<class T>
+struct ring_allocator {
+    ring_storage<T> allocate(size_t count) {
+        return make_cache_aligned<T>(count);
+    }
+};
+
+// backs the buffer with 2MB huge pages so very large rings stop thrashing the
+// TLB. Tries a real hugetlb mapping first (needs pages reserved by the
+// administrator), then falls back to a normal mapping with a transparent-
+// huge-page hint, so construction never fails just because the pool is empty.
+template<class T>
+struct huge_page_allocator {
+    static constexpr size_t huge_page = 2 * 1024 * 1024;
+    ring_storage<T> allocate(size_t count) {
+        // hugetlb mappings must be mapped AND unmapped in whole huge pages,
+        // so round the length up before trying
+        size_t bytes = (count * sizeof(T) + huge_page - 1) / huge_page * huge_page;
+        void* mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem == MAP_FAILED) {
+            mem = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED)
+                throw bad_alloc();
+            madvise(mem, bytes, MADV_HUGEPAGE); // best effort
+        }
+        // the mapping is raw memory, so construct the elements ourselves and
+        // have the deleter destroy them before unmapping
+        T* first = static_cast<T*>(mem);
+        for (size_t i = 0; i < count; ++i)
+            new (first + i) T();
+        return ring_storage<T>(first, [count, bytes](T* p) {
+            for (size_t i = count; i > 0; --i)
+                p[i-1].~T();
+            munmap(p, bytes);
+        });
+    }
+};
+
+// carves rings out of one preallocated arena. Copies of the allocator share
+// the arena, so hundreds of rings can be placed back to back in a single
+// allocation; each carve starts on a cache line boundary. The arena block is
+// kept alive by the deleters of the buffers carved from it and is freed when
+// the last of them (and the allocator itself) is gone.
 template<class T>
+class arena_allocator {
+public:
+    // an arena of the given size in bytes
+    arena_allocator(size_t bytes)
+        : block(new char[bytes], default_delete<char[]>{})
+        , used(new size_t(0))
+        , bytes(bytes)
+    {}
+    ring_storage<T> allocate(size_t count) {
+        // bump the cursor to the next cache line boundary
+        uintptr_t base = (uintptr_t)(void*)block.get();
+        size_t off = *used;
+        off += (cache_line - (base + off) % cache_line) % cache_line;
+        if (off + count * sizeof(T) > bytes)
+            throw bad_alloc(); // arena exhausted
+        T* first = reinterpret_cast<T*>(block.get() + off);
+        *used = off + count * sizeof(T);
+        for (size_t i = 0; i < count; ++i)
+            new (first + i) T();
+        // the deleter holds a reference to the arena so the block outlives
+        // every ring carved from it
+        shared_ptr<char> keep = block;
+        return ring_storage<T>(first, [keep, count](T* p) {
+            for (size_t i = count; i > 0; --i)
+                p[i-1].~T();
+        });
+    }
+private:
+    shared_ptr<char> block; // the arena itself
+    shared_ptr<size_t> used; // bump cursor, shared between copies
+    size_t bytes; // total arena size
+};
+
+// Copies n bytes with non-temporal (streaming) stores where the hardware
+// has them: destination lines go straight to memory instead of being pulled
+// into L1/L2 first, so writing a payload the producer will never read again
+// does not evict the thread's working set. Callers MUST fence (sfence)
+// before publishing a cursor over data written this way - non-temporal
+// stores are not ordered by ordinary release stores.
+inline void stream_copy(void* dst, void const* src, size_t n) {
+#if defined(__SSE2__)
+    char* d = (char*)dst;
+    char const* s = (char const*)src;
+    // align the destination; the head and tail go through normal stores
+    while (n && ((uintptr_t)d & 15)) { *d++ = *s++; --n; }
+#if defined(__AVX2__)
+    while (n >= 32 && !((uintptr_t)d & 31)) {
+        _mm256_stream_si256((__m256i*)d, _mm256_loadu_si256((__m256i const*)s));
+        d += 32; s += 32; n -= 32;
+    }
+#endif
+    while (n >= 16) {
+        _mm_stream_si128((__m128i*)d, _mm_loadu_si128((__m128i const*)s));
+        d += 16; s += 16; n -= 16;
+    }
+    while (n--) *d++ = *s++;
+#else
+    memcpy(dst, src, n);
+#endif
+}
+
+// the fence that makes streamed data visible before a cursor publication
+inline void stream_fence() {
+#if defined(__SSE2__)
+    _mm_sfence();
+#endif
+}
+
+// rounds n up to the next power of two (1 stays 1)
+constexpr inline size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+// Wrap policies: how an out-of-range index is brought back into the buffer.
+// Every ring funnels its index arithmetic through one of these, so the wrap
+// strategy is a compile-time choice.
+
+// the default: plain integer modulo, works for any capacity
+struct modulo_wrap {
+    size_t cycle = 0; // index where there is a complete cycle
+    modulo_wrap() = default;
+    modulo_wrap(size_t capacity) : cycle(capacity) {}
+    // number of slots the policy addresses
+    size_t capacity() const { return cycle; }
+    // returns n (mod capacity). A default-constructed policy (cycle 0, the
+    // state of a default-constructed or moved-from ring) maps everything to
+    // 0 instead of dividing by zero, which keeps size() at 0 and full()
+    // true - exactly the safe do-nothing behavior an empty shell should have
+    size_t operator()(size_t n) const { return cycle ? n % cycle : 0; }
+};
+
+// the fast mode: capacity is rounded up to a power of two so wrapping is a
+// single AND with a mask instead of a hardware divide
+struct mask_wrap {
+    size_t mask = 0; // capacity-1, where capacity is a power of two
+    mask_wrap() = default;
+    mask_wrap(size_t capacity) : mask(round_up_pow2(capacity) - 1) {}
+    // number of slots the policy addresses (may exceed the requested capacity)
+    size_t capacity() const { return mask + 1; }
+    // returns n (mod capacity), computed as a mask
+    size_t operator()(size_t n) const { return n & mask; }
+};
+
+// Timing policy: everything counting_stats does, plus a timestamp on every
+// element as it goes in and a log-bucketed (HDR-style) histogram of how long
+// it sat in the ring, recorded as it comes out. Because every insert and
+// every removal funnels through the stats hooks in FIFO order, the policy
+// mirrors the ring with its own compile-time-sized circular stamp buffer -
+// Depth must be a power of two at least as large as the ring's capacity.
+// The snapshot is a plain copy with a percentile helper, so p99.9 queue
+// delay is a scrape away and the hot path never sees a probe. Pair it with
+// drop_newest rings: the overwrite policy retires elements without a
+// matching get and would desynchronize the stamp buffer. drain() is fine:
+// the in-flight stamps follow the drained elements into the snapshot (see
+// on_drain), so both rings keep honest delays.
+template<size_t Depth = 4096>
+struct timing_stats {
+    static_assert((Depth & (Depth - 1)) == 0, "Depth must be a power of two");
+    // one coherent view: the counters plus the delay distribution
+    struct snapshot {
+        size_t enqueued, dequeued, dropped, occupancy, high_water;
+        array<uint64_t, 64> delay_hist; // bucket i holds delays of i bits (ns)
+        uint64_t samples;
+        // upper bound of the smallest bucket prefix covering fraction p
+        uint64_t delay_percentile_ns(double p) const {
+            uint64_t want = (uint64_t)(p * samples), seen = 0;
+            for (size_t i = 0; i < delay_hist.size(); ++i) {
+                seen += delay_hist[i];
+                if (seen >= want)
+                    return (uint64_t)1 << i;
+            }
+            return ~(uint64_t)0;
+        }
+    };
+    size_t enqueued = 0, dequeued = 0, dropped = 0, high_water = 0;
+    array<uint64_t, Depth> stamps{}; // mirrors the ring's occupancy, FIFO
+    array<uint64_t, 64> hist{};
+    uint64_t head = 0, tail = 0, samples = 0;
+    static uint64_t now_ns() {
+        return chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    void on_put(size_t n, size_t occupancy) {
+        enqueued += n;
+        if (occupancy > high_water)
+            high_water = occupancy;
+        uint64_t now = now_ns(); // one clock read per batch
+        for (size_t i = 0; i < n; ++i)
+            stamps[head++ & (Depth - 1)] = now;
+    }
+    void on_drop(size_t n) { dropped += n; }
+    // drain() support: the in-flight stamps belong to the elements the
+    // snapshot carried away, so hand the FIFO over and start ours empty -
+    // the cumulative counters and histogram stay here with the live ring
+    void on_drain(timing_stats& snapshot) {
+        snapshot.stamps = stamps;
+        snapshot.head = head;
+        snapshot.tail = tail;
+        head = tail = 0;
+    }
+    void on_get(size_t n) {
+        dequeued += n;
+        uint64_t now = now_ns();
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t delay = now - stamps[tail++ & (Depth - 1)];
+            // log2 bucket; clamped so even a nonsense delay (top bit set)
+            // lands in the last bucket instead of past the array
+            unsigned b = (unsigned)bit_width(delay);
+            ++hist[b < 64 ? b : 63];
+            ++samples;
+        }
+    }
+    snapshot snap(size_t occupancy) const {
+        return { enqueued, dequeued, dropped, occupancy, high_water,
+                 hist, samples };
+    }
+};
+
+// what put() does when the ring is full: keep the old contents and drop the
+// new element (the historical behavior), or evict the oldest element so the
+// ring always holds the most recent N samples - the right policy for
+// telemetry streams that care about now, not history
+enum class full_policy { drop_newest, overwrite_oldest };
+
+// Stats policies: opt-in instrumentation of what a ring is doing. The ring
+// calls the hooks below on every operation; with the default no_stats policy
+// they are empty inline functions and the whole surface costs nothing.
+
+// the default: no instrumentation, no storage, no work
+struct no_stats {
+    struct snapshot {}; // nothing was counted, so there is nothing to see
+    void on_put(size_t /*n*/, size_t /*occupancy*/) {}
+    void on_drop(size_t /*n*/) {}
+    void on_get(size_t /*n*/) {}
+    void on_drain(no_stats& /*snapshot*/) {}
+    snapshot snap(size_t /*occupancy*/) const { return {}; }
+};
+
+// counts traffic and watermarks so capacity planning does not need a
+// sampling thread: total enqueued/dequeued, puts rejected because the ring
+// was full, and the occupancy high-water mark
+struct counting_stats {
+    // one coherent view of the counters, cheap to scrape
+    struct snapshot {
+        size_t enqueued, dequeued, dropped, occupancy, high_water;
+    };
+    size_t enqueued = 0, dequeued = 0, dropped = 0, high_water = 0;
+    void on_put(size_t n, size_t occupancy) {
+        enqueued += n;
+        if (occupancy > high_water)
+            high_water = occupancy;
+    }
+    void on_drop(size_t n) { dropped += n; }
+    void on_get(size_t n) { dequeued += n; }
+    void on_drain(counting_stats& /*snapshot*/) {}
+    snapshot snap(size_t occupancy) const {
+        return { enqueued, dequeued, dropped, occupancy, high_water };
+    }
+};
+
+// A contiguous run of elements inside a ring's storage. Because the data sits
+// in a circular array, the readable (or writable) region of a ring is always
+// at most two of these: the run up to the wrap point and the run after it.
+template<class T>
+struct ring_segment {
+    T* data = nullptr; // first element of the run
+    size_t count = 0; // number of elements in the run
+};
+
+// An iterator for a cirular before (returned by the begin() and end() methods).
+// A conforming random-access iterator: the position it carries is an absolute
+// offset from the start of the ring and is only wrapped down to a buffer index
+// when dereferencing. That makes begin() == end() exactly when the ring is
+// empty while a full ring's end() sits a whole lap ahead (the old wrapped-index
+// comparison could not tell those apart), and it makes iterator distance and
+// ordering wrap-aware for free, which is what std::sort, std::copy and the
+// parallel algorithms need.
+template<class T, class Wrap = modulo_wrap>
 class ring_iterator {
-    int idx; // current index
-    int cycle; // index where there is a complete cycle
-    T* buffer; // pointer to the element where idx lies (i.e buffer[idx])
+    size_t pos; // absolute position; the buffer index is wrap(pos)
+    Wrap wrap; // wrap policy bringing a position back into the buffer
+    T* buffer; // pointer to the underlying array
 public:
-    ring_iterator(size_t idx, size_t cycle, T* buffer) : idx(idx), cycle(cycle), buffer(buffer) {}
-    
+    // the traits the std algorithms look for
+    using iterator_category = random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    ring_iterator() : pos(0), wrap(), buffer(nullptr) {}
+    ring_iterator(size_t pos, Wrap wrap, T* buffer) : pos(pos), wrap(wrap), buffer(buffer) {}
+
     // operator+ delegates work to operator+=
-    ring_iterator operator+(int offset) const {
+    ring_iterator operator+(difference_type offset) const {
         ring_iterator copy(*this);
         copy += offset;
         return copy;
     }
-    
+    friend ring_iterator operator+(difference_type offset, ring_iterator const& it) {
+        return it + offset;
+    }
+
     // operator- delegates work to operator-=
-    ring_iterator operator-(int offset) const {
+    ring_iterator operator-(difference_type offset) const {
         ring_iterator copy(*this);
         copy -= offset;
         return copy;
     }
-    
-    // preincrement: increase the index by 1
+
+    // distance between two iterators; absolute positions make this exact even
+    // when the range crosses the wrap point
+    friend difference_type operator-(ring_iterator const& lhs, ring_iterator const& rhs) {
+        return (difference_type)(lhs.pos - rhs.pos);
+    }
+
+    // preincrement: increase the position by 1
     ring_iterator& operator++() {
-        idx = (idx + 1) % cycle;
+        ++pos;
         return *this;
     }
-    
-    // predecrement: if decrementing idx would yield a negative number, return cycle-1
-    // otherwise subtract 1
+
+    // predecrement: decrease the position by 1
     ring_iterator& operator--() {
-        idx = (idx == 0) ? cycle-1 : idx-1;
-        return *this;
+        return operator-=(1);
     }
-    
+
     // postincrement: create a copy, modify the current object, return the old value
     ring_iterator operator++(int) {
         ring_iterator copy(*this);
         operator++();
         return copy;
     }
-    
+
     // postdecrement: create a copy, modify the current object, return the old value
     ring_iterator operator--(int) {
         ring_iterator copy(*this);
         operator--();
         return copy;
     }
-    
-    // += is simple: increase the index by the specified amount and use % to wrap around
-    ring_iterator& operator+=(int offset) {
-        idx = (idx + offset) % cycle;
+
+    // += just moves the absolute position; wrapping happens on dereference
+    ring_iterator& operator+=(difference_type offset) {
+        if (offset < 0)
+            return operator-=(-offset);
+        pos += offset;
         return *this;
     }
-    
-    // With -= we need to handle going past 0 and onto the other side of the ring.
-    ring_iterator& operator-=(int offset) {
-        idx -= offset; // decrease by offset
-        // if the decrement yeiled a negative number, continually subtract |tmpidx|-1 from cycle
-        while (idx < 0)
-            idx = cycle - (abs(idx) - 1);
+
+    // With -= we need to handle going past position 0: step back onto the
+    // previous lap by adding whole cycles first
+    ring_iterator& operator-=(difference_type offset) {
+        if (offset < 0)
+            return operator+=(-offset);
+        while ((difference_type)pos < offset)
+            pos += wrap.capacity();
+        pos -= offset;
         return *this;
     }
-    
-    // the element in the buffer
-    T& operator*() {
-        return buffer[idx];
+
+    // the element in the buffer. Like a pointer, a const iterator still
+    // yields a mutable element - the concepts behind the std algorithms
+    // require dereference to look the same from const and non-const
+    // iterators alike
+    T& operator*() const {
+        return buffer[wrap(pos)];
+    }
+
+    // member access through the iterator
+    T* operator->() const {
+        return buffer + wrap(pos);
     }
-    
-    // the element in the buffer
-    T const& operator*() const {
-        return buffer[idx];
+
+    // indexed access relative to this iterator
+    T& operator[](difference_type offset) const {
+        return buffer[wrap(pos + offset)];
     }
-    
-    // operator==
+
+    // comparisons are on the absolute position, so an iterator that has
+    // lapped the ring compares greater than one that has not
     friend bool operator==(ring_iterator const& lhs, ring_iterator const& rhs) {
-        return lhs.idx == rhs.idx;
+        return lhs.pos == rhs.pos;
     }
-    
-    // operator!=
     friend bool operator!=(ring_iterator const& lhs, ring_iterator const& rhs) {
         return !(lhs == rhs);
     }
+    friend bool operator<(ring_iterator const& lhs, ring_iterator const& rhs) {
+        return lhs.pos < rhs.pos;
+    }
+    friend bool operator>(ring_iterator const& lhs, ring_iterator const& rhs) {
+        return rhs < lhs;
+    }
+    friend bool operator<=(ring_iterator const& lhs, ring_iterator const& rhs) {
+        return !(rhs < lhs);
+    }
+    friend bool operator>=(ring_iterator const& lhs, ring_iterator const& rhs) {
+        return !(lhs < rhs);
+    }
 };
 
-template<class T>
+// A readahead wrapper over ring_iterator for scans much larger than the
+// last-level cache: every step issues a software prefetch distance elements
+// ahead of the one being processed - wrap-aware for free, since the
+// underlying iterator's absolute position wraps on dereference - so DRAM
+// latency hides behind the work on the current element instead of stalling
+// every dereference.
+template<class T, class Wrap = modulo_wrap>
+class prefetch_iterator {
+    ring_iterator<T, Wrap> it; // the real position
+    size_t distance; // how many elements of lookahead to keep in flight
+    // one prefetch per cache line, not per element: elements share lines, and
+    // the extra index wrap a prefetch costs should be paid once per line
+    static constexpr size_t stride = sizeof(T) < cache_line ? cache_line / sizeof(T) : 1;
+    size_t until = 0; // steps left before the next prefetch is due
+public:
+    using iterator_category = forward_iterator_tag; // a scan, not an index
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    prefetch_iterator(ring_iterator<T, Wrap> it, size_t distance)
+        : it(it), distance(distance) {}
+
+    // step and keep the window primed
+    prefetch_iterator& operator++() {
+        ++it;
+        if (until == 0) {
+            __builtin_prefetch(&it[(ptrdiff_t)distance]);
+            until = stride;
+        }
+        --until;
+        return *this;
+    }
+    prefetch_iterator operator++(int) {
+        prefetch_iterator copy(*this);
+        operator++();
+        return copy;
+    }
+    T& operator*() const { return *it; }
+    T* operator->() const { return it.operator->(); }
+    friend bool operator==(prefetch_iterator const& lhs, prefetch_iterator const& rhs) {
+        return lhs.it == rhs.it;
+    }
+    friend bool operator!=(prefetch_iterator const& lhs, prefetch_iterator const& rhs) {
+        return !(lhs == rhs);
+    }
+};
+
+// the begin/end pair range-for wants, handed out by RingBuffer::prefetched()
+template<class T, class Wrap = modulo_wrap>
+struct ring_prefetch_range {
+    prefetch_iterator<T, Wrap> first, last;
+    prefetch_iterator<T, Wrap> begin() const { return first; }
+    prefetch_iterator<T, Wrap> end() const { return last; }
+};
+
+template<class T, class Wrap = modulo_wrap, class Alloc = ring_allocator<T>, class Stats = no_stats>
 class RingBuffer {
 public:
     // generic iterator tag denoting internal iterator type
-    using iterator = ring_iterator<T>;
+    using iterator = ring_iterator<T, Wrap>;
 public:
     RingBuffer() = default;
-    // capacity constructor
-    RingBuffer(size_t);
+    // capacity constructor; the allocator decides where the storage lives
+    RingBuffer(size_t, Alloc = Alloc());
+    // capacity + full-policy constructor: overwrite_oldest turns the ring
+    // into an always-current window over the newest N elements
+    RingBuffer(size_t, full_policy, Alloc = Alloc());
     // capacity + initial value constructor
-    RingBuffer(size_t, T const&);
+    RingBuffer(size_t, T const&, Alloc = Alloc());
+    // deep copies: the occupied region is copied segment by segment (two
+    // memcpys for trivial types)
+    RingBuffer(RingBuffer const&);
+    RingBuffer& operator=(RingBuffer const&);
+    // moves steal the storage in O(1) and leave the source empty; with real
+    // moves a vector of rings can finally resize without deep-copying every
+    // element
+    RingBuffer(RingBuffer&&) noexcept;
+    RingBuffer& operator=(RingBuffer&&) noexcept;
+    // O(1) exchange of storage and cursors
+    void swap(RingBuffer&) noexcept;
+    // O(1) snapshot-and-drain: hands the ring's entire contents over in a
+    // freshly-allocated ring and leaves this one empty, so a flush thread can
+    // process the snapshot offline while the producer stalls for a pointer
+    // swap instead of an O(n) element-by-element copy-out
+    RingBuffer drain();
     // retrieves the next element to be read
     T get() const;
     // insertion
     void put(T const&);
+    // move insertion
+    void put(T&&);
+    // constructs the element in the slot from the given arguments
+    template<class... Args>
+    void emplace(Args&&... args);
+    // non-throwing single-shot operations for poll loops that legitimately
+    // race a producer: one cursor check, one predictable branch, no
+    // exception machinery on the failure path
+    bool try_put(T const&);
+    bool try_put(T&&);
+    optional<T> try_get();
+    // bulk insertion: copies up to count elements in, returns how many fit
+    size_t put_bulk(T const*, size_t count);
+    // bulk removal: copies up to count elements out, returns how many there were
+    size_t get_bulk(T*, size_t count);
+    // zero-copy read: exposes the readable region as at most two contiguous
+    // segments to be processed in place (either may be empty)
+    pair<ring_segment<T const>, ring_segment<T const>> peek() const;
+    // scatter/gather I/O for byte rings: the ring IS the receive (or send)
+    // buffer. read_from_fd readv()s straight into the free region's two
+    // segments and write_to_fd writev()s the readable region out - one
+    // syscall, no staging copy. Both return what the syscall returned and
+    // advance the cursors by however many bytes actually moved
+    ssize_t read_from_fd(int fd);
+    ssize_t write_to_fd(int fd);
+    // commits a read of up to n elements previously looked at through peek()
+    void consume(size_t n);
+    // the write-side mirror of peek()/consume(), named like the SPSC ring's
+    // pair: claim() exposes the free region as two in-place segments and
+    // publish() makes the first n filled slots visible. This is the hook an
+    // asynchronous producer (the io_uring pump below) fills through
+    pair<ring_segment<T>, ring_segment<T>> claim(size_t n);
+    void publish(size_t n);
     // deletion
     void pop();
     // access
@@ -121,88 +609,537 @@ public:
     iterator const begin() const;
     iterator end();
     iterator const end() const;
+    // readahead traversal: like begin()/end() but each step prefetches
+    // distance elements ahead, hiding DRAM latency on scans over rings much
+    // bigger than the cache. distance 0 picks a default from the element
+    // size (roughly 1KB of lookahead)
+    ring_prefetch_range<T, Wrap> prefetched(size_t distance = 0);
+    // selects non-temporal stores for the trivial copy paths: right for 2KB+
+    // payloads in rings much bigger than the cache, where pulling every
+    // destination line into L1 only evicts the rest of the thread's working
+    // set for data nobody reads back soon
+    void stream_mode(bool on) { streaming = on; }
     // size
     size_t size() const;
     bool empty() const;
     bool full() const;
+    // instrumentation: one coherent view of the stats policy's counters
+    // (only well-formed for a policy that defines a snapshot, like
+    // counting_stats; rings on the default no_stats never mention it)
+    typename Stats::snapshot stats_snapshot() const;
 private:
     // helper functions:
     // put overloads to check for trivial types
     void put(T const&, true_type);
     void put(T const&, false_type);
+    // copies the occupied region over from another ring with the same layout
+    void copy_slots(RingBuffer const&, true_type);
+    void copy_slots(RingBuffer const&, false_type);
+    // bulk copy overloads to check for trivial types: the trivial versions
+    // split the run at the wrap point and memcpy each contiguous segment
+    void copy_in(T const*, size_t, true_type);
+    void copy_in(T const*, size_t, false_type);
+    void copy_out(T*, size_t, true_type) const;
+    void copy_out(T*, size_t, false_type) const;
     // returns n (mod capacity)
     int overflow(int n) const;
+    // free slots left (the sacrificed slot excluded); 0 for the capacity-less
+    // shell a default-constructed or moved-from ring is
+    size_t room() const {
+        size_t c = wrap.capacity();
+        return c ? c - 1 - size() : 0;
+    }
 private:
-    // RAII circular buffer
-    shared_ptr<T> buffer = nullptr;
-    // read, write -> indicies into the buffer
-    // length, capacity -> current size and capacity of the buffer
-    mutable size_t read, write, length, capacity = 0;
+    // wrap policy bringing an index back into the buffer; also knows the
+    // capacity (declared first so the buffer allocation below can consult it)
+    Wrap wrap;
+    // where the storage comes from; kept so copies can allocate from the
+    // same place (e.g. the same arena)
+    Alloc alloc;
+    // RAII circular buffer, uniquely owned
+    ring_storage<T> buffer = nullptr;
+    // read, write -> indicies into the buffer; occupancy is derived from
+    // them (the old shared length counter was written by both the producing
+    // and consuming side of every operation, a guaranteed coherence hot spot)
+    mutable size_t read = 0, write = 0;
+    // what happens to a put() when there is no room
+    full_policy onFull = full_policy::drop_newest;
+    // whether the trivial copy paths use non-temporal stores
+    bool streaming = false;
+    // stats policy hooks fire on every operation; no_stats makes this free
+    [[no_unique_address]] mutable Stats counters;
 };
 
 // capacity constructor: construct buffer and set initial values
-template<class T>
-RingBuffer<T>::RingBuffer(size_t capacity)
-    : buffer(new T[capacity], default_delete<T[]>{})
+template<class T, class Wrap, class Alloc, class Stats>
+RingBuffer<T, Wrap, Alloc, Stats>::RingBuffer(size_t capacity, Alloc alloc)
+    : wrap(capacity+1) // +1 for modulo
+    , alloc(move(alloc))
+    , buffer(this->alloc.allocate(wrap.capacity()))
     , read(0)
     , write(0)
-    , length(0)
-    , capacity(capacity+1) // +1 for modulo
 {}
- 
-template<class T>
-RingBuffer<T>::RingBuffer(size_t capacity, T const& value)
-    : RingBuffer(capacity) // delegate common work to previous constructor
+
+// capacity + full-policy constructor
+template<class T, class Wrap, class Alloc, class Stats>
+RingBuffer<T, Wrap, Alloc, Stats>::RingBuffer(size_t capacity, full_policy policy, Alloc alloc)
+    : RingBuffer(capacity, move(alloc)) // delegate common work
 {
-    // fill array
-    for (int i = 0; i < capacity; ++i)
-        put(value);
+    onFull = policy;
 }
 
-// put delegates to 1 of 2 constructors based on whether T is a trivial type
-template<class T>
-void RingBuffer<T>::put(T const& value) {
-    if (!full()) {
-        put(value, is_trivially_copyable<T>{}); // call other overload
-        write = overflow(write + 1); // increase position
-        ++length; // increase length
+template<class T, class Wrap, class Alloc, class Stats>
+RingBuffer<T, Wrap, Alloc, Stats>::RingBuffer(size_t capacity, T const& value, Alloc alloc)
+    : RingBuffer(capacity, move(alloc)) // delegate common work to previous constructor
+{
+    // fill the array in one streaming pass instead of capacity put() calls:
+    // no branch, wrap or length update per element, and fill_n over the
+    // contiguous storage vectorizes (memset/SIMD) for trivial types
+    fill_n(buffer.get(), capacity, value);
+    write = capacity;
+    counters.on_put(capacity, size());
+}
+
+// deep copy: fresh storage from the same allocator, cursors and counters
+// carried over, and only the occupied region actually copied
+template<class T, class Wrap, class Alloc, class Stats>
+RingBuffer<T, Wrap, Alloc, Stats>::RingBuffer(RingBuffer const& other)
+    : wrap(other.wrap)
+    , alloc(other.alloc)
+    , buffer(alloc.allocate(wrap.capacity()))
+    , read(other.read)
+    , write(other.write)
+    , onFull(other.onFull)
+    , streaming(other.streaming)
+    , counters(other.counters)
+{
+    copy_slots(other, is_trivially_copyable<T>{});
+}
+
+// copy assignment reuses the copy constructor and then steals its state
+template<class T, class Wrap, class Alloc, class Stats>
+RingBuffer<T, Wrap, Alloc, Stats>& RingBuffer<T, Wrap, Alloc, Stats>::operator=(RingBuffer const& other) {
+    if (this != &other) {
+        RingBuffer copy(other);
+        wrap = copy.wrap;
+        alloc = copy.alloc;
+        buffer = move(copy.buffer);
+        read = copy.read;
+        write = copy.write;
+        onFull = copy.onFull;
+        streaming = copy.streaming;
+        counters = copy.counters;
     }
+    return *this;
+}
+
+// move construction: steal the storage and cursors, leave the source in
+// the same state as a default-constructed ring - capacity-less, reporting
+// size 0 and full, dropping every operation harmlessly. The policies reset
+// too: an overwrite_oldest source would otherwise evict past the full()
+// check and write through the storage it no longer owns
+template<class T, class Wrap, class Alloc, class Stats>
+RingBuffer<T, Wrap, Alloc, Stats>::RingBuffer(RingBuffer&& other) noexcept
+    : wrap(other.wrap)
+    , alloc(move(other.alloc))
+    , buffer(move(other.buffer))
+    , read(other.read)
+    , write(other.write)
+    , onFull(other.onFull)
+    , streaming(other.streaming)
+    , counters(other.counters)
+{
+    other.wrap = Wrap();
+    other.read = other.write = 0;
+    other.onFull = full_policy::drop_newest;
+    other.streaming = false;
+    other.counters = Stats();
+}
+
+// move assignment swaps with the source; the old storage dies with it
+template<class T, class Wrap, class Alloc, class Stats>
+RingBuffer<T, Wrap, Alloc, Stats>& RingBuffer<T, Wrap, Alloc, Stats>::operator=(RingBuffer&& other) noexcept {
+    swap(other);
+    return *this;
+}
+
+// everything the ring owns is a handful of words plus the storage handle, so
+// swap is a few pointer exchanges - no element is touched
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::swap(RingBuffer& other) noexcept {
+    std::swap(wrap, other.wrap);
+    std::swap(alloc, other.alloc);
+    std::swap(buffer, other.buffer);
+    std::swap(read, other.read);
+    std::swap(write, other.write);
+    std::swap(onFull, other.onFull);
+    std::swap(streaming, other.streaming);
+    std::swap(counters, other.counters);
+}
+
+// drain is built on swap: allocate an empty twin (same capacity, same
+// allocator, same full policy), exchange everything, then put the cumulative
+// stats back on the live ring - the snapshot is transient, the counters
+// describe the ring that keeps running
+template<class T, class Wrap, class Alloc, class Stats>
+RingBuffer<T, Wrap, Alloc, Stats> RingBuffer<T, Wrap, Alloc, Stats>::drain() {
+    RingBuffer fresh(wrap.capacity() - 1, alloc);
+    fresh.onFull = onFull;
+    fresh.streaming = streaming;
+    swap(fresh);
+    std::swap(counters, fresh.counters); // keep the history here
+    // stats policies with per-element state (the timing stamps) hand the
+    // in-flight part to the snapshot, whose elements it describes
+    counters.on_drain(fresh.counters);
+    return fresh; // now holds the old contents
+}
+
+// free-function swap so generic code (and std::swap-style calls) find it
+template<class T, class Wrap, class Alloc, class Stats>
+void swap(RingBuffer<T, Wrap, Alloc, Stats>& lhs, RingBuffer<T, Wrap, Alloc, Stats>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// trivial copy-over: the occupied region lives at the same indices in both
+// rings, at most two contiguous segments
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::copy_slots(RingBuffer const& other, true_type) {
+    size_t len = size();
+    if (len == 0)
+        return; // nothing to copy - and a capacity-less shell has no buffer
+    size_t first = wrap.capacity() - read; // elements before the wrap point
+    if (first > len)
+        first = len;
+    memcpy(buffer.get() + read, other.buffer.get() + read, first * sizeof(T));
+    memcpy(buffer.get(), other.buffer.get(), (len - first) * sizeof(T));
+}
+
+// if T is not trivially copyable fall back to one copy-assignment per element
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::copy_slots(RingBuffer const& other, false_type) {
+    for (size_t i = 0, len = size(); i < len; ++i)
+        buffer.get()[overflow(read + i)] = other.buffer.get()[overflow(read + i)];
+}
+
+// put keeps the historical fire-and-forget shape; the outcome-reporting
+// logic lives in try_put so the bookkeeping exists exactly once
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::put(T const& value) {
+    try_put(value);
 }
 
 // get returns the next object to be read (which is stored in the index at read)
-template<class T>
-T RingBuffer<T>::get() const {
+template<class T, class Wrap, class Alloc, class Stats>
+T RingBuffer<T, Wrap, Alloc, Stats>::get() const {
     if (!empty()) {
-        T tmp = at(read); // get element
+        T tmp = front(); // get element
         read = overflow(read + 1); // increase read
-        --length; // decrement size
+        counters.on_get(1);
         return tmp;
     }
     // if the buffer is empty this operation cannot work
     throw logic_error("empty buffer");
 }
 
-// trivial put function calls memcpy and copies bytes directly into the buffer
-template<class T>
-void RingBuffer<T>::put(T const& value, true_type) {
-    memcpy(reinterpret_cast<void*>(&*end()), reinterpret_cast<void*>(const_cast<T*>(&value)), sizeof(value));
+// move-aware put: the value is moved into the slot instead of copied, so
+// types that own heap storage (strings and the like) hand it over instead of
+// reallocating
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::put(T&& value) {
+    try_put(move(value));
+}
+
+// emplace builds the element from the caller's arguments. The slots already
+// hold live objects (the buffer is a plain array), so the element is built
+// as a temporary and move-assigned into the slot rather than placement-new'd
+// over a live object.
+template<class T, class Wrap, class Alloc, class Stats>
+template<class... Args>
+void RingBuffer<T, Wrap, Alloc, Stats>::emplace(Args&&... args) {
+    put(T(forward<Args>(args)...)); // binds to the move overload above
+}
+
+// try_put is put() with the outcome reported instead of swallowed: false
+// means full-and-dropped, and the hot poll loop gets a single predictable
+// branch. Under overwrite_oldest a full ring instead evicts its oldest
+// element (one wrap, one length update - not the pop()+put() pair callers
+// used to emulate this with) and the insert always succeeds
+template<class T, class Wrap, class Alloc, class Stats>
+bool RingBuffer<T, Wrap, Alloc, Stats>::try_put(T const& value) {
+    if (full()) {
+        if (onFull == full_policy::drop_newest) {
+            counters.on_drop(1);
+            return false;
+        }
+        // evict the oldest element to make room; it counts as dropped
+        // because it is data the ring lost
+        read = overflow(read + 1);
+        counters.on_drop(1);
+    }
+    put(value, is_trivially_copyable<T>{}); // call other overload
+    write = overflow(write + 1); // increase position
+    counters.on_put(1, size());
+    return true;
+}
+
+// move flavor of try_put, same eviction rule
+template<class T, class Wrap, class Alloc, class Stats>
+bool RingBuffer<T, Wrap, Alloc, Stats>::try_put(T&& value) {
+    if (full()) {
+        if (onFull == full_policy::drop_newest) {
+            counters.on_drop(1);
+            return false;
+        }
+        read = overflow(read + 1);
+        counters.on_drop(1);
+    }
+    // for a trivially copyable type a move is just a copy, so take the same
+    // tag-dispatched path as the copy overload - it is the one that knows
+    // about streaming stores and their fence; only genuinely movable types
+    // move-assign into the slot
+    if (is_trivially_copyable<T>::value)
+        put(value, true_type());
+    else
+        *end() = move(value); // move into the slot
+    write = overflow(write + 1); // increase position
+    counters.on_put(1, size());
+    return true;
+}
+
+// try_get is get() without the exception: an empty optional means an empty
+// ring, which for a consumer racing a producer is the normal case, not an
+// error. The element is moved out of the slot since the slot is dead after
+// the read cursor passes it
+template<class T, class Wrap, class Alloc, class Stats>
+optional<T> RingBuffer<T, Wrap, Alloc, Stats>::try_get() {
+    if (empty())
+        return nullopt;
+    optional<T> out(move(front())); // take the element
+    read = overflow(read + 1); // increase read
+    counters.on_get(1);
+    return out;
+}
+
+// bulk insertion: like put() but the bookkeeping (wrap + length update) is
+// paid once for the whole batch instead of once per element. Under
+// drop_newest it copies as many elements as there is room for and returns
+// that count; under overwrite_oldest the batch always lands - just enough
+// of the oldest elements are evicted to make room, and a batch bigger than
+// the ring keeps only its newest capacity-sized tail. Evictions count as
+// drops, exactly like the single-element path.
+template<class T, class Wrap, class Alloc, class Stats>
+size_t RingBuffer<T, Wrap, Alloc, Stats>::put_bulk(T const* values, size_t count) {
+    size_t free = room();
+    if (count > free && onFull == full_policy::overwrite_oldest) {
+        size_t usable = wrap.capacity() ? wrap.capacity() - 1 : 0;
+        if (count >= usable) {
+            // the batch alone fills the ring: everything already stored and
+            // the batch's own oldest part are history now
+            counters.on_drop(size() + (count - usable));
+            values += count - usable;
+            count = usable;
+            read = write; // the old contents are gone
+        } else {
+            // evict just enough of the oldest to fit the whole batch
+            size_t evict = count - free;
+            read = overflow(read + evict);
+            counters.on_drop(evict);
+        }
+        free = count;
+    }
+    size_t n = count < free ? count : free;
+    copy_in(values, n, is_trivially_copyable<T>{});
+    write = overflow(write + n);
+    counters.on_put(n, size());
+    if (n < count)
+        counters.on_drop(count - n); // the part that did not fit
+    return n;
+}
+
+// bulk removal: the mirror image of put_bulk()
+template<class T, class Wrap, class Alloc, class Stats>
+size_t RingBuffer<T, Wrap, Alloc, Stats>::get_bulk(T* out, size_t count) {
+    size_t len = size();
+    size_t n = count < len ? count : len;
+    copy_out(out, n, is_trivially_copyable<T>{});
+    read = overflow(read + n);
+    counters.on_get(n);
+    return n;
+}
+
+// peek exposes the readable region in place: the run from read up to the wrap
+// point, then the run from the start of the buffer. The consumer processes the
+// elements where they sit (no copy out of the ring) and afterwards commits how
+// far it got with consume().
+template<class T, class Wrap, class Alloc, class Stats>
+auto RingBuffer<T, Wrap, Alloc, Stats>::peek() const -> pair<ring_segment<T const>, ring_segment<T const>> {
+    size_t len = size();
+    size_t first = wrap.capacity() - read; // elements before the wrap point
+    if (first > len)
+        first = len;
+    return { { buffer.get() + read, first },
+             { buffer.get(), len - first } };
+}
+
+// claim exposes up to n slots of the free region in place; nothing is
+// visible to readers until publish(). Unlike the SPSC ring's claim there is
+// no cursor reservation - the caller owns the ring between claim and publish
+template<class T, class Wrap, class Alloc, class Stats>
+auto RingBuffer<T, Wrap, Alloc, Stats>::claim(size_t n) -> pair<ring_segment<T>, ring_segment<T>> {
+    size_t free = room();
+    if (n > free)
+        n = free;
+    size_t first = wrap.capacity() - write; // room before the wrap point
+    if (first > n)
+        first = n;
+    return { { buffer.get() + write, first },
+             { buffer.get(), n - first } };
+}
+
+// publish moves the write cursor over n slots the caller filled through
+// claim(); the usual insert bookkeeping, paid once per batch
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::publish(size_t n) {
+    write = overflow(write + n);
+    counters.on_put(n, size());
+}
+
+// readv straight into the ring: the free region is at most two contiguous
+// segments (from write to the wrap point, then from the start to read), so
+// one vectored read fills both without a staging buffer. The fd paths never
+// evict, whatever the full policy: bytes that do not fit stay queued in the
+// socket, which is where an event loop expects its backpressure
+template<class T, class Wrap, class Alloc, class Stats>
+ssize_t RingBuffer<T, Wrap, Alloc, Stats>::read_from_fd(int fd) {
+    static_assert(sizeof(T) == 1, "fd I/O treats the ring as a byte buffer");
+    size_t free = room();
+    if (free == 0)
+        return 0; // nowhere to put the bytes
+    size_t first = wrap.capacity() - write; // room before the wrap point
+    if (first > free)
+        first = free;
+    iovec iov[2] = {
+        { buffer.get() + write, first },
+        { buffer.get(), free - first }
+    };
+    ssize_t n = readv(fd, iov, iov[1].iov_len ? 2 : 1);
+    if (n > 0) {
+        write = overflow(write + n);
+        counters.on_put(n, size());
+    }
+    return n;
+}
+
+// writev the readable region out: the mirror image of read_from_fd
+template<class T, class Wrap, class Alloc, class Stats>
+ssize_t RingBuffer<T, Wrap, Alloc, Stats>::write_to_fd(int fd) {
+    static_assert(sizeof(T) == 1, "fd I/O treats the ring as a byte buffer");
+    size_t len = size();
+    if (len == 0)
+        return 0; // nothing to send
+    size_t first = wrap.capacity() - read; // bytes before the wrap point
+    if (first > len)
+        first = len;
+    iovec iov[2] = {
+        { buffer.get() + read, first },
+        { buffer.get(), len - first }
+    };
+    ssize_t n = writev(fd, iov, iov[1].iov_len ? 2 : 1);
+    if (n > 0) {
+        read = overflow(read + n);
+        counters.on_get(n);
+    }
+    return n;
+}
+
+// consume is pop() for a whole peeked batch: it only moves the read cursor,
+// the elements themselves were already processed in place
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::consume(size_t n) {
+    size_t len = size();
+    if (n > len)
+        n = len;
+    read = overflow(read + n);
+    counters.on_get(n);
+}
+
+// trivial copy-in: at most two contiguous segments (before and after the wrap
+// point), each moved with a single memcpy
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::copy_in(T const* values, size_t n, true_type) {
+    if (n == 0)
+        return; // nothing to copy - and a capacity-less shell has no buffer
+    size_t first = wrap.capacity() - write; // room before the wrap point
+    if (first > n)
+        first = n;
+    if (streaming) {
+        stream_copy(buffer.get() + write, values, first * sizeof(T));
+        stream_copy(buffer.get(), values + first, (n - first) * sizeof(T));
+        stream_fence(); // data before cursor
+    } else {
+        memcpy(buffer.get() + write, values, first * sizeof(T));
+        memcpy(buffer.get(), values + first, (n - first) * sizeof(T));
+    }
+}
+
+// if T is not trivially copyable fall back to one copy-assignment per element
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::copy_in(T const* values, size_t n, false_type) {
+    for (size_t i = 0; i < n; ++i)
+        buffer.get()[overflow(write + i)] = values[i];
+}
+
+// trivial copy-out: same two-segment split, reading from the read cursor
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::copy_out(T* out, size_t n, true_type) const {
+    if (n == 0)
+        return; // nothing to copy - and a capacity-less shell has no buffer
+    size_t first = wrap.capacity() - read; // elements before the wrap point
+    if (first > n)
+        first = n;
+    memcpy(out, buffer.get() + read, first * sizeof(T));
+    memcpy(out + first, buffer.get(), (n - first) * sizeof(T));
+}
+
+// if T is not trivially copyable fall back to one copy-assignment per
+// element, with the same readahead the prefetched() scan uses
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::copy_out(T* out, size_t n, false_type) const {
+    size_t ahead = 1024 / sizeof(T) + 1; // about 1KB of lookahead
+    for (size_t i = 0; i < n; ++i) {
+        if (i + ahead < n)
+            __builtin_prefetch(buffer.get() + overflow(read + i + ahead));
+        out[i] = buffer.get()[overflow(read + i)];
+    }
+}
+
+// trivial put function copies bytes directly into the buffer; in streaming
+// mode the copy bypasses the cache and is fenced before the caller bumps
+// the write cursor
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::put(T const& value, true_type) {
+    if (streaming) {
+        stream_copy(&*end(), &value, sizeof(value));
+        stream_fence(); // data before cursor
+    } else {
+        memcpy(reinterpret_cast<void*>(&*end()), reinterpret_cast<void*>(const_cast<T*>(&value)), sizeof(value));
+    }
 }
 
 // if T is not trivially copyable simply call copy-assignment operator
-template<class T>
-void RingBuffer<T>::put(T const& value, false_type) {
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::put(T const& value, false_type) {
     *end() = value;
 }
 
 // removes the pending element
 // (similar to get())
-template<class T>
-void RingBuffer<T>::pop() {
+template<class T, class Wrap, class Alloc, class Stats>
+void RingBuffer<T, Wrap, Alloc, Stats>::pop() {
     if (!empty()) {
         // increase read
         read = overflow(read + 1);
-        // decrement length
-        --length;
+        counters.on_get(1);
     } else {
         // if the buffer is empty this operation cannot be performed
         throw logic_error("empty");
@@ -210,44 +1147,58 @@ void RingBuffer<T>::pop() {
 }
 
 // returns a ring_iterator into the position in the array to be read from
-template<class T>
-auto RingBuffer<T>::begin() const -> iterator const {
-    return iterator(read, capacity, buffer.get());
+template<class T, class Wrap, class Alloc, class Stats>
+auto RingBuffer<T, Wrap, Alloc, Stats>::begin() const -> iterator const {
+    return iterator(read, wrap, buffer.get());
 }
 
 // non-const version: same as above
-template<class T>
-auto RingBuffer<T>::begin() -> iterator {
-    return iterator(read, capacity, buffer.get());
+template<class T, class Wrap, class Alloc, class Stats>
+auto RingBuffer<T, Wrap, Alloc, Stats>::begin() -> iterator {
+    return iterator(read, wrap, buffer.get());
 }
 
-// returns a ring_iterator into the position in the array to be written to
-template<class T>
-auto RingBuffer<T>::end() const -> iterator const {
-    return iterator(write, capacity, buffer.get());
+// returns a ring_iterator one past the last readable element. Built from
+// read + size() rather than the write cursor so that a full ring's end() is
+// a whole lap past begin() instead of colliding with it
+template<class T, class Wrap, class Alloc, class Stats>
+auto RingBuffer<T, Wrap, Alloc, Stats>::end() const -> iterator const {
+    return iterator(read + size(), wrap, buffer.get());
 }
 
 // non-const version: same as above
-template<class T>
-auto RingBuffer<T>::end() -> iterator {
-    return iterator(write, capacity, buffer.get());
+template<class T, class Wrap, class Alloc, class Stats>
+auto RingBuffer<T, Wrap, Alloc, Stats>::end() -> iterator {
+    return iterator(read + size(), wrap, buffer.get());
+}
+
+// the readahead range over the readable region; primes the first window up
+// front so the scan never starts cold
+template<class T, class Wrap, class Alloc, class Stats>
+ring_prefetch_range<T, Wrap> RingBuffer<T, Wrap, Alloc, Stats>::prefetched(size_t distance) {
+    if (distance == 0)
+        distance = 1024 / sizeof(T) + 1; // about 1KB of lookahead
+    auto b = begin();
+    for (size_t i = 0; i < distance && i < size(); ++i)
+        __builtin_prefetch(&b[(ptrdiff_t)i]);
+    return { { b, distance }, { end(), distance } };
 }
 
 // returns the element to be read 
-template<class T>
-T& RingBuffer<T>::front() {
+template<class T, class Wrap, class Alloc, class Stats>
+T& RingBuffer<T, Wrap, Alloc, Stats>::front() {
     return *begin();
 }
 
 // const-version: same as above
-template<class T>
-T const& RingBuffer<T>::front() const {
+template<class T, class Wrap, class Alloc, class Stats>
+T const& RingBuffer<T, Wrap, Alloc, Stats>::front() const {
     return *begin();
 }
 
 // returns the element to be written to
-template<class T>
-T& RingBuffer<T>::back() {
+template<class T, class Wrap, class Alloc, class Stats>
+T& RingBuffer<T, Wrap, Alloc, Stats>::back() {
     // if there is 1 element return the first one in the buffer
     if (size() <= 1)
         return *begin();
@@ -256,59 +1207,1354 @@ T& RingBuffer<T>::back() {
 }
 
 // const-version: same as above
-template<class T>
-T const& RingBuffer<T>::back() const {
+template<class T, class Wrap, class Alloc, class Stats>
+T const& RingBuffer<T, Wrap, Alloc, Stats>::back() const {
     // const_cast is safe here as back() is returned and bound to a 
     // reference to const
-    return const_cast<RingBuffer<T>&>(*this).back();
+    return const_cast<RingBuffer<T, Wrap, Alloc, Stats>&>(*this).back();
 }
 
-template<class T>
-size_t RingBuffer<T>::size() const {
-    return length;
+template<class T, class Wrap, class Alloc, class Stats>
+size_t RingBuffer<T, Wrap, Alloc, Stats>::size() const {
+    return overflow(write + wrap.capacity() - read);
+}
+
+// scrapes the counters plus the current occupancy in one go
+template<class T, class Wrap, class Alloc, class Stats>
+typename Stats::snapshot RingBuffer<T, Wrap, Alloc, Stats>::stats_snapshot() const {
+    return counters.snap(size());
 }
 
 // array is full if the condition below is satisifed.
-template<class T>
-bool RingBuffer<T>::full() const {
-    return read == (write + 1) % capacity;
+template<class T, class Wrap, class Alloc, class Stats>
+bool RingBuffer<T, Wrap, Alloc, Stats>::full() const {
+    return read == (size_t)overflow(write + 1);
 }
 
-template<class T>
-bool RingBuffer<T>::empty() const {
-    return length == 0;
+template<class T, class Wrap, class Alloc, class Stats>
+bool RingBuffer<T, Wrap, Alloc, Stats>::empty() const {
+    return read == write;
 }
 
 // accesses an element at idx in a ring-like fashion.
-template<class T>
-T& RingBuffer<T>::operator[](size_t idx) {
+template<class T, class Wrap, class Alloc, class Stats>
+T& RingBuffer<T, Wrap, Alloc, Stats>::operator[](size_t idx) {
     return *(buffer.get() + overflow(read + idx));
 }
 
 // const-version: same as above
-template<class T>
-T const& RingBuffer<T>::operator[](size_t idx) const {
-    return const_cast<RingBuffer<T>&>(*this)[idx];
+template<class T, class Wrap, class Alloc, class Stats>
+T const& RingBuffer<T, Wrap, Alloc, Stats>::operator[](size_t idx) const {
+    return const_cast<RingBuffer<T, Wrap, Alloc, Stats>&>(*this)[idx];
 }
 
 // at is the same operator[] except it does bounds checking
-template<class T>
-T& RingBuffer<T>::at(size_t idx) {
-    if (empty() || !(0 <= idx && idx < length))
+template<class T, class Wrap, class Alloc, class Stats>
+T& RingBuffer<T, Wrap, Alloc, Stats>::at(size_t idx) {
+    if (!empty() && idx < size())
         return operator[](idx);
     throw out_of_range("index too large");
 }
 
 // const-version: same as above
-template<class T>
-T const& RingBuffer<T>::at(size_t idx) const {
-    if (empty() || !(0 <= idx && idx < length))
+template<class T, class Wrap, class Alloc, class Stats>
+T const& RingBuffer<T, Wrap, Alloc, Stats>::at(size_t idx) const {
+    if (!empty() && idx < size())
         return operator[](idx);
     throw out_of_range("index too large");
 }
 
 // returns n (mod capacity)
-template<class T>
-int RingBuffer<T>::overflow(int n) const {
-    return n % capacity;
+template<class T, class Wrap, class Alloc, class Stats>
+int RingBuffer<T, Wrap, Alloc, Stats>::overflow(int n) const {
+    return wrap(n);
+}
+
+// A single-producer/single-consumer ring buffer. One thread may call put()
+// while another thread calls get() concurrently with no external lock: the
+// read and write cursors are atomics, published with release stores and
+// observed with acquire loads, so the element written into a slot is always
+// visible before the consumer is told the slot is ready (and vice versa for
+// freeing a slot). There is no shared length counter - occupancy is derived
+// from the two cursors.
+template<class T, class Wrap = modulo_wrap>
+class SPSCRingBuffer {
+public:
+    // capacity constructor
+    SPSCRingBuffer(size_t);
+    // insertion: returns false instead of dropping silently when full
+    bool put(T const&);
+    // removal: copies the next element into out, returns false when empty
+    bool get(T& out);
+    // claim/publish (the LMAX disruptor pattern): the producer reserves up to
+    // n slots and gets them back as spans into the buffer itself, builds or
+    // deserializes events directly in place, then publishes the filled range
+    // with one cursor store. No stack temporary, no copy, and the release
+    // publication is amortized over the whole batch
+    pair<ring_segment<T>, ring_segment<T>> claim(size_t n);
+    void publish(size_t n);
+    // blocking flavors: spin briefly for the case where the opposite side is
+    // actively running, then park on the opposing cursor until it moves.
+    // These turn the ring into a complete bounded queue - an idle consumer
+    // sleeps in the kernel instead of burning a core on empty() polls
+    void put_wait(T const&);
+    void get_wait(T& out);
+    // coroutine integration: co_await ring.async_get() suspends the consumer
+    // coroutine while the ring is empty and the next put() resumes it (on the
+    // producer's thread); co_await ring.async_put(v) is the mirror image for
+    // a full ring. One suspended coroutine per side, matching the
+    // one-producer/one-consumer contract
+    struct get_awaiter {
+        SPSCRingBuffer& ring;
+        T value{};
+        bool have = false;
+        // try immediately; if the element is already there we never suspend
+        bool await_ready() { return have = ring.get(value); }
+        // register our handle, then recheck: if the producer published while
+        // we were registering we must not stay suspended on it
+        bool await_suspend(coroutine_handle<> h) {
+            // the moment the handle is published the producer may resume (and
+            // even finish) the coroutine, destroying this awaiter with the
+            // frame - so grab the ring reference first and touch nothing
+            // through members afterwards
+            SPSCRingBuffer& r = ring;
+            r.consumerWaiter.store(h.address(), memory_order_seq_cst);
+            if (r.read.load(memory_order_seq_cst)
+                != r.write.load(memory_order_seq_cst)) {
+                // take the registration back; if it is already gone the
+                // producer owns our handle and a resume is on the way
+                if (r.consumerWaiter.exchange(nullptr, memory_order_acq_rel))
+                    return false; // keep running, the element is there
+            }
+            return true;
+        }
+        T await_resume() {
+            if (!have)
+                while (!ring.get(value)) // we were woken because it is there
+                    ;
+            return move(value);
+        }
+    };
+    struct put_awaiter {
+        SPSCRingBuffer& ring;
+        T value;
+        bool done = false;
+        bool await_ready() { return done = ring.put(value); }
+        bool await_suspend(coroutine_handle<> h) {
+            // same frame-lifetime discipline as get_awaiter above
+            SPSCRingBuffer& r = ring;
+            r.producerWaiter.store(h.address(), memory_order_seq_cst);
+            if (r.read.load(memory_order_seq_cst)
+                != r.overflow(r.write.load(memory_order_seq_cst) + 1)) {
+                // a slot freed up while we were registering
+                if (r.producerWaiter.exchange(nullptr, memory_order_acq_rel))
+                    return false;
+            }
+            return true;
+        }
+        void await_resume() {
+            if (!done)
+                while (!ring.put(value)) // woken because a slot freed up
+                    ;
+        }
+    };
+    get_awaiter async_get() { return { *this }; }
+    put_awaiter async_put(T value) { return { *this, move(value) }; }
+    // size
+    size_t size() const;
+    bool empty() const;
+    bool full() const;
+private:
+    // returns n (mod capacity)
+    size_t overflow(size_t n) const;
+private:
+    // resumes a coroutine parked by async_get()/async_put(), if any. The
+    // fence pairs with the seq_cst registration in await_suspend: either we
+    // see the handle, or the awaiter's recheck sees our cursor store -
+    // never neither
+    void wake_consumer() {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (consumerWaiter.load(memory_order_relaxed))
+            if (void* h = consumerWaiter.exchange(nullptr, memory_order_acq_rel))
+                coroutine_handle<>::from_address(h).resume();
+    }
+    void wake_producer() {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (producerWaiter.load(memory_order_relaxed))
+            if (void* h = producerWaiter.exchange(nullptr, memory_order_acq_rel))
+                coroutine_handle<>::from_address(h).resume();
+    }
+    // how long the blocking operations spin before parking; under load the
+    // opposite cursor nearly always moves within this budget and the futex is
+    // never touched
+    static constexpr int spin_limit = 1024;
+    // wrap policy bringing an index back into the buffer
+    Wrap wrap;
+    // RAII circular buffer, uniquely owned (starts on a cache line boundary)
+    ring_storage<T> buffer = nullptr;
+    // read -> index the consumer reads from, only written by the consumer
+    // write -> index the producer writes to, only written by the producer
+    // each cursor gets its own cache line so the producer's write bump and the
+    // consumer's read bump do not ping-pong a single line between cores (wrap
+    // and buffer above are read-only after construction, so sharing is fine).
+    // Each side also keeps a private cached copy of the PEER's cursor on its
+    // own line and only re-reads the real, contended atomic when the cache
+    // says full/empty: while there is room the producer never loads read and
+    // the consumer never loads write, cutting cross-core line transfers per
+    // operation from ~3 toward 1
+    alignas(cache_line) atomic<size_t> read;
+    size_t writeCache = 0; // consumer-private, lives on the read line
+    alignas(cache_line) atomic<size_t> write;
+    size_t readCache = 0; // producer-private, lives on the write line
+    // one suspended coroutine handle per side, off the hot cursor lines
+    alignas(cache_line) atomic<void*> consumerWaiter{nullptr};
+    atomic<void*> producerWaiter{nullptr};
+};
+
+// capacity constructor: construct buffer and set initial values
+template<class T, class Wrap>
+SPSCRingBuffer<T, Wrap>::SPSCRingBuffer(size_t capacity)
+    : wrap(capacity+1) // +1 for modulo
+    , buffer(make_cache_aligned<T>(wrap.capacity()))
+    , read(0)
+    , write(0)
+{}
+
+// the producer stores the element first and only then publishes the new write
+// cursor (release), so by the time the consumer's acquire load sees the cursor
+// move the element is guaranteed to be in place
+template<class T, class Wrap>
+bool SPSCRingBuffer<T, Wrap>::put(T const& value) {
+    size_t w = write.load(memory_order_relaxed); // only we write this
+    size_t next = overflow(w + 1);
+    // check the cached read cursor first; only when it claims we are full do
+    // we pay for a load of the real thing (which the consumer's core owns)
+    if (next == readCache) {
+        readCache = read.load(memory_order_acquire);
+        if (next == readCache)
+            return false;
+    }
+    buffer.get()[w] = value;
+    write.store(next, memory_order_release); // publish the element
+    // wake a parked consumer if there is one; the library tracks waiters
+    // itself (with the fencing that needs), so this is a load and a branch
+    // when nobody is asleep
+    write.notify_one();
+    wake_consumer(); // and a suspended consumer coroutine likewise
+    return true;
+}
+
+// the consumer reads the element first and only then publishes the new read
+// cursor (release), which hands the slot back to the producer
+template<class T, class Wrap>
+bool SPSCRingBuffer<T, Wrap>::get(T& out) {
+    size_t r = read.load(memory_order_relaxed); // only we write this
+    // same trick on the consumer side: trust the cached write cursor until
+    // it says empty, then refresh from the contended atomic
+    if (r == writeCache) {
+        writeCache = write.load(memory_order_acquire);
+        if (r == writeCache)
+            return false;
+    }
+    out = buffer.get()[r];
+    read.store(overflow(r + 1), memory_order_release); // free the slot
+    // wake a parked producer if there is one
+    read.notify_one();
+    wake_producer(); // and a suspended producer coroutine likewise
+    return true;
+}
+
+// claim reserves writable slots without making them visible: clamps the
+// request to the free space and returns it as at most two contiguous
+// segments (before and after the wrap point). The slots stay invisible to
+// the consumer until publish()
+template<class T, class Wrap>
+auto SPSCRingBuffer<T, Wrap>::claim(size_t n) -> pair<ring_segment<T>, ring_segment<T>> {
+    size_t w = write.load(memory_order_relaxed); // only we write this
+    size_t r = read.load(memory_order_acquire);
+    // free slots, minus the one sacrificed for the full() check
+    size_t room = overflow(r + wrap.capacity() - 1 - w);
+    if (n > room)
+        n = room;
+    size_t first = wrap.capacity() - w; // slots before the wrap point
+    if (first > n)
+        first = n;
+    return { { buffer.get() + w, first },
+             { buffer.get(), n - first } };
+}
+
+// publish moves the write cursor over the first n claimed slots - the same
+// release store put() does per element, paid once for the whole batch
+template<class T, class Wrap>
+void SPSCRingBuffer<T, Wrap>::publish(size_t n) {
+    size_t w = write.load(memory_order_relaxed);
+    write.store(overflow(w + n), memory_order_release); // the events go live here
+    write.notify_one(); // a parked consumer sees the whole batch at once
+    wake_consumer();
+}
+
+// blocking put: try for a while, then go to sleep on the read cursor - the
+// only thing that can make room is the consumer moving it. atomic::wait
+// re-checks the value it parks on, so a cursor that moved between our check
+// and the wait simply does not block and the outer loop retries
+template<class T, class Wrap>
+void SPSCRingBuffer<T, Wrap>::put_wait(T const& value) {
+    for (;;) {
+        // adaptive spin: under load the consumer frees a slot long before
+        // the budget runs out
+        for (int spin = 0; spin < spin_limit; ++spin)
+            if (put(value))
+                return;
+        // park until the read cursor moves off its current position
+        size_t r = read.load(memory_order_acquire);
+        if (full())
+            read.wait(r, memory_order_acquire);
+    }
+}
+
+// blocking get: the mirror image, parked on the write cursor
+template<class T, class Wrap>
+void SPSCRingBuffer<T, Wrap>::get_wait(T& out) {
+    for (;;) {
+        for (int spin = 0; spin < spin_limit; ++spin)
+            if (get(out))
+                return;
+        // park until the write cursor moves off its current position
+        size_t w = write.load(memory_order_acquire);
+        if (empty())
+            write.wait(w, memory_order_acquire);
+    }
+}
+
+// occupancy derived from the cursors; a snapshot only, since the other
+// thread may move its cursor at any time
+template<class T, class Wrap>
+size_t SPSCRingBuffer<T, Wrap>::size() const {
+    size_t r = read.load(memory_order_acquire);
+    size_t w = write.load(memory_order_acquire);
+    return overflow(w + wrap.capacity() - r);
+}
+
+template<class T, class Wrap>
+bool SPSCRingBuffer<T, Wrap>::empty() const {
+    return read.load(memory_order_acquire) == write.load(memory_order_acquire);
+}
+
+// array is full if the condition below is satisifed.
+template<class T, class Wrap>
+bool SPSCRingBuffer<T, Wrap>::full() const {
+    return read.load(memory_order_acquire)
+        == overflow(write.load(memory_order_acquire) + 1);
+}
+
+// returns n (mod capacity)
+template<class T, class Wrap>
+size_t SPSCRingBuffer<T, Wrap>::overflow(size_t n) const {
+    return wrap(n);
+}
+
+// A multi-producer/multi-consumer ring buffer (Dmitry Vyukov's bounded MPMC
+// queue). Any number of threads may call put() and get() concurrently. Each
+// slot carries its own sequence number which encodes whose turn the slot is:
+// a producer may fill slot i once sequence == ticket, and a consumer may empty
+// it once sequence == ticket+1. Producers and consumers claim tickets from the
+// write/read counters with compare-and-swap, so two producers can never win
+// the same slot. The counters run forever and are reduced to a slot index with
+// the same overflow() wrap the other rings use.
+template<class T, class Wrap = modulo_wrap>
+class MPMCRingBuffer {
+public:
+    // capacity constructor
+    MPMCRingBuffer(size_t);
+    // insertion: returns false instead of dropping silently when full
+    bool put(T const&);
+    // removal: copies the next element into out, returns false when empty
+    bool get(T& out);
+    // size
+    size_t size() const;
+    bool empty() const;
+    bool full() const;
+private:
+    // a slot: the element plus the sequence number that gates access to it
+    struct slot {
+        atomic<size_t> sequence;
+        T data;
+    };
+    // returns n (mod capacity)
+    size_t overflow(size_t n) const;
+private:
+    // wrap policy bringing a ticket back into the buffer; with mask_wrap the
+    // usable capacity rounds up to the next power of two
+    Wrap wrap;
+    // RAII circular buffer of slots, uniquely owned (cache line aligned)
+    ring_storage<slot> buffer = nullptr;
+    // read, write -> ever-increasing ticket counters (not wrapped); the slot
+    // for a ticket is buffer[overflow(ticket)]
+    // the counters are contended by every producer (write) and every consumer
+    // (read), so each lives on its own cache line
+    alignas(cache_line) atomic<size_t> read;
+    alignas(cache_line) atomic<size_t> write;
+};
+
+// capacity constructor: construct the slots and stamp each with its own index
+// so that slot i is initially the producer's turn for ticket i
+template<class T, class Wrap>
+MPMCRingBuffer<T, Wrap>::MPMCRingBuffer(size_t capacity)
+    : wrap(capacity)
+    , buffer(make_cache_aligned<slot>(wrap.capacity()))
+    , read(0)
+    , write(0)
+{
+    for (size_t i = 0; i < wrap.capacity(); ++i)
+        buffer.get()[i].sequence.store(i, memory_order_relaxed);
+}
+
+// a producer loops: read the next ticket, inspect the slot it maps to, and
+// act on the difference between the slot's sequence and the ticket:
+//   == 0 -> the slot is free; try to claim the ticket with CAS
+//    < 0 -> the consumer lapped us, i.e. the buffer is full
+//    > 0 -> another producer claimed this ticket first; reload and retry
+template<class T, class Wrap>
+bool MPMCRingBuffer<T, Wrap>::put(T const& value) {
+    size_t ticket = write.load(memory_order_relaxed);
+    for (;;) {
+        slot& s = buffer.get()[overflow(ticket)];
+        size_t seq = s.sequence.load(memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)ticket;
+        if (diff == 0) {
+            // our turn: claim the ticket; on failure another producer took it
+            if (write.compare_exchange_weak(ticket, ticket + 1, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            ticket = write.load(memory_order_relaxed);
+        }
+    }
+    slot& s = buffer.get()[overflow(ticket)];
+    s.data = value;
+    // publish: sequence == ticket+1 is what the consumer of this ticket waits for
+    s.sequence.store(ticket + 1, memory_order_release);
+    return true;
+}
+
+// the consumer mirrors put(): it waits for sequence == ticket+1 (the producer
+// has published), claims the ticket by CAS on read, and afterwards bumps the
+// sequence a full lap forward so the slot becomes writable for ticket+capacity
+template<class T, class Wrap>
+bool MPMCRingBuffer<T, Wrap>::get(T& out) {
+    size_t ticket = read.load(memory_order_relaxed);
+    for (;;) {
+        slot& s = buffer.get()[overflow(ticket)];
+        size_t seq = s.sequence.load(memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(ticket + 1);
+        if (diff == 0) {
+            // published and unclaimed: try to claim it
+            if (read.compare_exchange_weak(ticket, ticket + 1, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            ticket = read.load(memory_order_relaxed);
+        }
+    }
+    slot& s = buffer.get()[overflow(ticket)];
+    out = s.data;
+    // hand the slot back to the producer one full lap ahead
+    s.sequence.store(ticket + wrap.capacity(), memory_order_release);
+    return true;
+}
+
+// occupancy derived from the ticket counters; a snapshot only
+template<class T, class Wrap>
+size_t MPMCRingBuffer<T, Wrap>::size() const {
+    size_t r = read.load(memory_order_acquire);
+    size_t w = write.load(memory_order_acquire);
+    return w - r;
+}
+
+template<class T, class Wrap>
+bool MPMCRingBuffer<T, Wrap>::empty() const {
+    return size() == 0;
+}
+
+// unlike the other rings no slot is sacrificed here, so full is size == capacity
+template<class T, class Wrap>
+bool MPMCRingBuffer<T, Wrap>::full() const {
+    return size() >= wrap.capacity();
+}
+
+// returns n (mod capacity)
+template<class T, class Wrap>
+size_t MPMCRingBuffer<T, Wrap>::overflow(size_t n) const {
+    return wrap(n);
+}
+
+// A file-backed ring buffer for trivially copyable element types. The data
+// AND the read/write cursors live in an mmap'd file behind a small versioned
+// header, so a process that crashes and restarts simply reopens the file and
+// resumes where it left off; persistence is the kernel's normal page
+// writeback rather than explicit I/O, with sync() available to force it.
+template<class T, class Wrap = modulo_wrap>
+class PersistentRingBuffer {
+    static_assert(is_trivially_copyable<T>::value,
+        "a file-backed ring can only hold trivially copyable elements");
+public:
+    // opens (or creates) the ring file; capacity only matters on creation and
+    // must match on reopen
+    PersistentRingBuffer(const char* path, size_t capacity);
+    // insertion: returns false instead of dropping silently when full
+    bool put(T const&);
+    // removal: copies the next element into out, returns false when empty
+    bool get(T& out);
+    // forces the mapped pages out to the file right now
+    void sync();
+    // size
+    size_t size() const;
+    bool empty() const;
+    bool full() const;
+private:
+    // the on-disk layout: this header sits at offset 0, the slots follow.
+    // fields are fixed-width so the layout is stable across builds
+    struct header {
+        uint32_t magic; // identifies a ring file
+        uint32_t version; // bumped when this struct changes
+        uint64_t element_size; // sizeof(T) at creation time
+        uint64_t slots; // wrap.capacity() at creation time
+        uint64_t read, write; // the live cursors
+    };
+    static constexpr uint32_t ring_magic = 0x52494e47; // "RING"
+    static constexpr uint32_t ring_version = 1;
+    // returns n (mod capacity)
+    size_t overflow(size_t n) const;
+private:
+    // wrap policy bringing an index back into the buffer
+    Wrap wrap;
+    // RAII mapping of the whole file; the header and slots point into it
+    shared_ptr<char> mapping = nullptr;
+    header* hdr = nullptr; // lives at the start of the mapping
+    T* data = nullptr; // the slots, right after the header
+};
+
+// open-or-create: a fresh (empty) file is sized and stamped with the header;
+// an existing file is validated against what this template would have written
+template<class T, class Wrap>
+PersistentRingBuffer<T, Wrap>::PersistentRingBuffer(const char* path, size_t capacity)
+    : wrap(capacity+1) // +1 for modulo
+{
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        throw runtime_error("cannot open ring file");
+    struct stat st;
+    fstat(fd, &st);
+    bool fresh = st.st_size == 0;
+    size_t len = sizeof(header) + wrap.capacity() * sizeof(T);
+    if (fresh && ftruncate(fd, len) != 0) {
+        close(fd);
+        throw runtime_error("cannot size ring file");
+    }
+    // a non-empty file of the wrong size would map fine but fault on access
+    // past its end, so refuse it up front
+    if (!fresh && (size_t)st.st_size != len) {
+        close(fd);
+        throw runtime_error("ring file has the wrong size");
+    }
+    void* mem = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        close(fd);
+        throw runtime_error("cannot map ring file");
+    }
+    // the fd is only needed to establish the mapping
+    close(fd);
+    mapping = shared_ptr<char>(static_cast<char*>(mem),
+                               [len](char* p) { munmap(p, len); });
+    hdr = reinterpret_cast<header*>(mapping.get());
+    data = reinterpret_cast<T*>(mapping.get() + sizeof(header));
+    if (fresh) {
+        hdr->magic = ring_magic;
+        hdr->version = ring_version;
+        hdr->element_size = sizeof(T);
+        hdr->slots = wrap.capacity();
+        hdr->read = hdr->write = 0;
+    } else if (hdr->magic != ring_magic || hdr->version != ring_version
+               || hdr->element_size != sizeof(T) || hdr->slots != wrap.capacity()) {
+        // refuse to reinterpret somebody else's bytes
+        throw runtime_error("ring file does not match this ring type");
+    }
+}
+
+// same cursor discipline as the in-memory rings, except the cursors live in
+// the mapping and therefore survive the process
+template<class T, class Wrap>
+bool PersistentRingBuffer<T, Wrap>::put(T const& value) {
+    size_t w = hdr->write;
+    size_t next = overflow(w + 1);
+    if (next == hdr->read)
+        return false; // full
+    memcpy(data + w, &value, sizeof(T));
+    // the cursor store is the commit point of the crash-safety story, so the
+    // payload copy must retire first - both are plain stores the compiler
+    // could otherwise reorder
+    atomic_signal_fence(memory_order_release);
+    hdr->write = next;
+    return true;
+}
+
+template<class T, class Wrap>
+bool PersistentRingBuffer<T, Wrap>::get(T& out) {
+    size_t r = hdr->read;
+    if (r == hdr->write)
+        return false; // empty
+    memcpy(&out, data + r, sizeof(T));
+    // same discipline on the consume side: the slot is only freed after the
+    // element has actually been copied out
+    atomic_signal_fence(memory_order_release);
+    hdr->read = overflow(r + 1);
+    return true;
+}
+
+// msync pushes the dirty pages to the file immediately instead of waiting
+// for writeback; useful before a deliberate shutdown
+template<class T, class Wrap>
+void PersistentRingBuffer<T, Wrap>::sync() {
+    msync(mapping.get(), sizeof(header) + wrap.capacity() * sizeof(T), MS_SYNC);
+}
+
+// occupancy derived from the mapped cursors
+template<class T, class Wrap>
+size_t PersistentRingBuffer<T, Wrap>::size() const {
+    return overflow(hdr->write + wrap.capacity() - hdr->read);
+}
+
+template<class T, class Wrap>
+bool PersistentRingBuffer<T, Wrap>::empty() const {
+    return hdr->read == hdr->write;
+}
+
+// array is full if the condition below is satisifed.
+template<class T, class Wrap>
+bool PersistentRingBuffer<T, Wrap>::full() const {
+    return hdr->read == overflow(hdr->write + 1);
+}
+
+// returns n (mod capacity)
+template<class T, class Wrap>
+size_t PersistentRingBuffer<T, Wrap>::overflow(size_t n) const {
+    return wrap(n);
+}
+
+// A ring buffer shared between processes. Same idea as the file-backed ring -
+// the control block (cursors) lives in the mapping next to the data, with a
+// layout that is stable across processes - but the backing is POSIX shared
+// memory (shm_open) and the cursors are atomics with the same acquire/release
+// discipline as SPSCRingBuffer, so one process can produce while another
+// consumes with a few atomic operations per message instead of a socket
+// round trip. One producer process and one consumer process at a time.
+template<class T, class Wrap = modulo_wrap>
+class SharedRingBuffer {
+    static_assert(is_trivially_copyable<T>::value,
+        "a shared-memory ring can only hold trivially copyable elements");
+    static_assert(atomic<size_t>::is_always_lock_free,
+        "cross-process cursors need address-free atomics");
+public:
+    // opens (or creates) the named shared memory segment; capacity only
+    // matters on creation and must match on attach
+    SharedRingBuffer(const char* name, size_t capacity);
+    // insertion: returns false instead of dropping silently when full
+    bool put(T const&);
+    // removal: copies the next element into out, returns false when empty
+    bool get(T& out);
+    // size
+    size_t size() const;
+    bool empty() const;
+    bool full() const;
+    // removes the named segment from the system once every attach is gone
+    static void unlink(const char* name) { shm_unlink(name); }
+private:
+    // the in-memory layout shared by every attached process. magic is
+    // stamped LAST (release) by the creator, so an attacher that sees it can
+    // trust the rest of the header
+    struct header {
+        atomic<uint32_t> magic;
+        uint32_t version;
+        uint64_t element_size;
+        uint64_t slots;
+        // same anti-false-sharing layout as the in-process SPSC ring
+        alignas(cache_line) atomic<size_t> read;
+        alignas(cache_line) atomic<size_t> write;
+    };
+    static constexpr uint32_t ring_magic = 0x53524e47; // "SRNG"
+    static constexpr uint32_t ring_version = 1;
+    // returns n (mod capacity)
+    size_t overflow(size_t n) const;
+private:
+    // wrap policy bringing an index back into the buffer
+    Wrap wrap;
+    // RAII mapping of the segment; the header and slots point into it
+    shared_ptr<char> mapping = nullptr;
+    header* hdr = nullptr; // lives at the start of the mapping
+    T* data = nullptr; // the slots, right after the header
+};
+
+// create-or-attach: O_EXCL decides who initializes. The creator sizes the
+// segment and stamps the header, publishing magic last; an attacher waits for
+// magic so it never reads a half-written header
+template<class T, class Wrap>
+SharedRingBuffer<T, Wrap>::SharedRingBuffer(const char* name, size_t capacity)
+    : wrap(capacity+1) // +1 for modulo
+{
+    size_t len = sizeof(header) + wrap.capacity() * sizeof(T);
+    bool creator = true;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        creator = false;
+        fd = shm_open(name, O_RDWR, 0644);
+        if (fd < 0)
+            throw runtime_error("cannot open shared ring");
+    }
+    if (creator && ftruncate(fd, len) != 0) {
+        close(fd);
+        shm_unlink(name);
+        throw runtime_error("cannot size shared ring");
+    }
+    if (!creator) {
+        // the creator may still be between shm_open and ftruncate: an
+        // attacher that maps a still-zero-length object faults on the first
+        // header access, so wait (bounded) for the segment to reach its size
+        struct stat st;
+        for (int tries = 0; fstat(fd, &st) == 0 && (size_t)st.st_size < len; ++tries) {
+            if (tries > 5000) {
+                close(fd);
+                throw runtime_error("shared ring was never sized");
+            }
+            usleep(1000);
+        }
+    }
+    void* mem = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        close(fd);
+        throw runtime_error("cannot map shared ring");
+    }
+    close(fd); // only needed to establish the mapping
+    mapping = shared_ptr<char>(static_cast<char*>(mem),
+                               [len](char* p) { munmap(p, len); });
+    hdr = reinterpret_cast<header*>(mapping.get());
+    data = reinterpret_cast<T*>(mapping.get() + sizeof(header));
+    if (creator) {
+        hdr->version = ring_version;
+        hdr->element_size = sizeof(T);
+        hdr->slots = wrap.capacity();
+        hdr->read.store(0, memory_order_relaxed);
+        hdr->write.store(0, memory_order_relaxed);
+        hdr->magic.store(ring_magic, memory_order_release); // open for business
+    } else {
+        // wait for the creator to finish stamping the header - bounded, so a
+        // creator that died mid-initialization leaves us with an error
+        // instead of a hung attacher
+        for (int tries = 0; hdr->magic.load(memory_order_acquire) != ring_magic; ++tries) {
+            if (tries > 5000)
+                throw runtime_error("shared ring was never initialized");
+            usleep(1000);
+        }
+        if (hdr->version != ring_version || hdr->element_size != sizeof(T)
+            || hdr->slots != wrap.capacity())
+            throw runtime_error("shared ring does not match this ring type");
+    }
+}
+
+// identical cursor discipline to SPSCRingBuffer::put(), against the mapped
+// cursors - release publishes the element to the other process
+template<class T, class Wrap>
+bool SharedRingBuffer<T, Wrap>::put(T const& value) {
+    size_t w = hdr->write.load(memory_order_relaxed); // only we write this
+    size_t next = overflow(w + 1);
+    if (next == hdr->read.load(memory_order_acquire))
+        return false; // full
+    memcpy(data + w, &value, sizeof(T));
+    hdr->write.store(next, memory_order_release); // publish the element
+    return true;
+}
+
+// identical cursor discipline to SPSCRingBuffer::get()
+template<class T, class Wrap>
+bool SharedRingBuffer<T, Wrap>::get(T& out) {
+    size_t r = hdr->read.load(memory_order_relaxed); // only we write this
+    if (r == hdr->write.load(memory_order_acquire))
+        return false; // empty
+    memcpy(&out, data + r, sizeof(T));
+    hdr->read.store(overflow(r + 1), memory_order_release); // free the slot
+    return true;
+}
+
+// occupancy derived from the mapped cursors; a snapshot only
+template<class T, class Wrap>
+size_t SharedRingBuffer<T, Wrap>::size() const {
+    size_t r = hdr->read.load(memory_order_acquire);
+    size_t w = hdr->write.load(memory_order_acquire);
+    return overflow(w + wrap.capacity() - r);
+}
+
+template<class T, class Wrap>
+bool SharedRingBuffer<T, Wrap>::empty() const {
+    return hdr->read.load(memory_order_acquire)
+        == hdr->write.load(memory_order_acquire);
+}
+
+// array is full if the condition below is satisifed.
+template<class T, class Wrap>
+bool SharedRingBuffer<T, Wrap>::full() const {
+    return hdr->read.load(memory_order_acquire)
+        == overflow(hdr->write.load(memory_order_acquire) + 1);
+}
+
+// returns n (mod capacity)
+template<class T, class Wrap>
+size_t SharedRingBuffer<T, Wrap>::overflow(size_t n) const {
+    return wrap(n);
+}
+
+// A fixed-capacity ring with the storage inline, like std::array: the
+// capacity is a template parameter, so there is no allocation, no pointer
+// indirection on access and no refcount - the whole object can be embedded
+// directly in the owning struct (per-connection state, tens of thousands of
+// them). The slot count rounds up to a power of two at compile time, so
+// overflow() is a constexpr mask.
+template<class T, size_t N>
+class FixedRingBuffer {
+public:
+    // generic iterator tag denoting internal iterator type
+    using iterator = ring_iterator<T, mask_wrap>;
+public:
+    FixedRingBuffer() = default;
+    // retrieves the next element to be read
+    T get();
+    // insertion
+    void put(T const&);
+    // move insertion
+    void put(T&&);
+    // deletion
+    void pop();
+    // access
+    T& front();
+    T const& front() const;
+    T& operator[](size_t idx);
+    T const& operator[](size_t idx) const;
+    // iterators
+    iterator begin();
+    iterator end();
+    // size
+    size_t size() const;
+    bool empty() const;
+    bool full() const;
+    // the capacity is a compile-time fact
+    static constexpr size_t capacity() { return N; }
+private:
+    // slot count: N usable elements plus the sacrificed slot, rounded up so
+    // the wrap is a mask
+    static constexpr size_t slots = round_up_pow2(N + 1);
+    static constexpr size_t mask = slots - 1;
+    // returns n (mod capacity): a single AND, resolved at compile time
+    static constexpr size_t overflow(size_t n) { return n & mask; }
+private:
+    // inline circular buffer - lives wherever the FixedRingBuffer lives
+    T buffer[slots] = {};
+    // read, write -> indicies into the buffer
+    // length -> current size of the buffer
+    size_t read = 0, write = 0, length = 0;
+};
+
+// get returns the next object to be read
+template<class T, size_t N>
+T FixedRingBuffer<T, N>::get() {
+    if (!empty()) {
+        T tmp = move(buffer[read]); // get element
+        read = overflow(read + 1); // increase read
+        --length; // decrement size
+        return tmp;
+    }
+    // if the buffer is empty this operation cannot work
+    throw logic_error("empty buffer");
+}
+
+// insertion: same drop-on-full behavior as the heap-backed ring
+template<class T, size_t N>
+void FixedRingBuffer<T, N>::put(T const& value) {
+    if (!full()) {
+        buffer[write] = value;
+        write = overflow(write + 1); // increase position
+        ++length; // increase length
+    }
+}
+
+// move insertion
+template<class T, size_t N>
+void FixedRingBuffer<T, N>::put(T&& value) {
+    if (!full()) {
+        buffer[write] = move(value);
+        write = overflow(write + 1); // increase position
+        ++length; // increase length
+    }
+}
+
+// removes the pending element
+template<class T, size_t N>
+void FixedRingBuffer<T, N>::pop() {
+    if (!empty()) {
+        read = overflow(read + 1);
+        --length;
+    } else {
+        throw logic_error("empty");
+    }
+}
+
+// returns the element to be read
+template<class T, size_t N>
+T& FixedRingBuffer<T, N>::front() {
+    return buffer[read];
+}
+
+// const-version: same as above
+template<class T, size_t N>
+T const& FixedRingBuffer<T, N>::front() const {
+    return buffer[read];
+}
+
+// accesses an element at idx in a ring-like fashion.
+template<class T, size_t N>
+T& FixedRingBuffer<T, N>::operator[](size_t idx) {
+    return buffer[overflow(read + idx)];
+}
+
+// const-version: same as above
+template<class T, size_t N>
+T const& FixedRingBuffer<T, N>::operator[](size_t idx) const {
+    return buffer[overflow(read + idx)];
+}
+
+// returns a ring_iterator into the position in the array to be read from
+template<class T, size_t N>
+auto FixedRingBuffer<T, N>::begin() -> iterator {
+    return iterator(read, mask_wrap(slots), buffer);
+}
+
+// returns a ring_iterator one past the last readable element
+template<class T, size_t N>
+auto FixedRingBuffer<T, N>::end() -> iterator {
+    return iterator(read + length, mask_wrap(slots), buffer);
+}
+
+template<class T, size_t N>
+size_t FixedRingBuffer<T, N>::size() const {
+    return length;
+}
+
+template<class T, size_t N>
+bool FixedRingBuffer<T, N>::empty() const {
+    return length == 0;
+}
+
+// full once N elements are in, regardless of the rounded slot count
+template<class T, size_t N>
+bool FixedRingBuffer<T, N>::full() const {
+    return length >= N;
+}
+
+// An asynchronous ingestion/drain stage built straight on the io_uring
+// syscalls (no liburing dependency). submit_read() queues a vectored read
+// targeting a ring's free segments, submit_write() queues a vectored write
+// from a ring's readable segments, and pump() pushes everything queued into
+// the kernel with ONE io_uring_enter and reaps completions, advancing the
+// matching ring cursor for each. Dozens of rings and sockets can ride a
+// single syscall per pump, where the synchronous path pays one per packet.
+// Single-threaded: one thread owns the pump and the rings attached to it.
+class UringPump {
+public:
+    // sets up an io_uring of the given queue depth and maps its rings
+    UringPump(unsigned entries = 64);
+    ~UringPump();
+    // no sensible way to share the kernel ring
+    UringPump(UringPump const&) = delete;
+    UringPump& operator=(UringPump const&) = delete;
+    // queue one read into ring's free region / one write from its readable
+    // region. false when the submission queue is full, the ring has no
+    // room/data, or that ring already has an operation of the same kind in
+    // flight (two in-flight reads would target the same free segments)
+    bool submit_read(int fd, RingBuffer<char>& ring);
+    bool submit_write(int fd, RingBuffer<char>& ring);
+    // submits everything queued, waits for at least min_complete completions,
+    // and advances ring cursors as completions land; returns how many landed
+    int pump(unsigned min_complete = 0);
+private:
+    // everything the completion handler needs to finish an operation; the
+    // iovecs must stay alive until the kernel is done with them
+    struct op {
+        RingBuffer<char>* ring = nullptr;
+        iovec iov[2];
+        bool writing = false;
+        bool live = false;
+    };
+    bool queue_op(int fd, RingBuffer<char>& ring, bool writing);
+private:
+    int ring_fd = -1;
+    // the three kernel-shared mappings
+    void* sqMap = MAP_FAILED; size_t sqMapLen = 0;
+    void* cqMap = MAP_FAILED; size_t cqMapLen = 0;
+    io_uring_sqe* sqes = nullptr; size_t sqesLen = 0;
+    // pointers into the mappings; head/tail are shared with the kernel and
+    // accessed with acquire/release like any other cross-"thread" cursor
+    atomic<unsigned>* sqHead = nullptr; atomic<unsigned>* sqTail = nullptr;
+    unsigned* sqArray = nullptr; unsigned sqMask = 0; unsigned sqEntries = 0;
+    atomic<unsigned>* cqHead = nullptr; atomic<unsigned>* cqTail = nullptr;
+    io_uring_cqe* cqes = nullptr; unsigned cqMask = 0;
+    // one record per possible in-flight operation, indexed by sqe user_data
+    vector<op> ops;
+    // sqes queued since the last io_uring_enter
+    unsigned pendingSubmit = 0;
+};
+
+// setup + the three mmaps the io_uring ABI hands us: the submission ring,
+// the completion ring, and the sqe array itself
+inline UringPump::UringPump(unsigned entries) {
+    io_uring_params p{};
+    ring_fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (ring_fd < 0)
+        throw runtime_error("io_uring_setup failed");
+    sqMapLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqMapLen = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    sqesLen = p.sq_entries * sizeof(io_uring_sqe);
+    sqMap = mmap(nullptr, sqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    cqMap = mmap(nullptr, cqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    sqes = (io_uring_sqe*)mmap(nullptr, sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (sqMap == MAP_FAILED || cqMap == MAP_FAILED || (void*)sqes == MAP_FAILED) {
+        // unwind only what succeeded; the throw below runs the member
+        // destructors, so no explicit destructor call here
+        if ((void*)sqes != MAP_FAILED && sqes) munmap(sqes, sqesLen);
+        if (cqMap != MAP_FAILED) munmap(cqMap, cqMapLen);
+        if (sqMap != MAP_FAILED) munmap(sqMap, sqMapLen);
+        close(ring_fd);
+        throw runtime_error("io_uring mmap failed");
+    }
+    char* sq = (char*)sqMap;
+    sqHead = (atomic<unsigned>*)(sq + p.sq_off.head);
+    sqTail = (atomic<unsigned>*)(sq + p.sq_off.tail);
+    sqMask = *(unsigned*)(sq + p.sq_off.ring_mask);
+    sqArray = (unsigned*)(sq + p.sq_off.array);
+    sqEntries = p.sq_entries;
+    char* cq = (char*)cqMap;
+    cqHead = (atomic<unsigned>*)(cq + p.cq_off.head);
+    cqTail = (atomic<unsigned>*)(cq + p.cq_off.tail);
+    cqMask = *(unsigned*)(cq + p.cq_off.ring_mask);
+    cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+    ops.resize(p.sq_entries);
+}
+
+inline UringPump::~UringPump() {
+    if ((void*)sqes != MAP_FAILED && sqes) munmap(sqes, sqesLen);
+    if (cqMap != MAP_FAILED) munmap(cqMap, cqMapLen);
+    if (sqMap != MAP_FAILED) munmap(sqMap, sqMapLen);
+    if (ring_fd >= 0) close(ring_fd);
+    sqes = nullptr; cqMap = sqMap = MAP_FAILED; ring_fd = -1;
+}
+
+// the shared submission logic: pick the ring segments, park them in an op
+// record, and write one sqe
+inline bool UringPump::queue_op(int fd, RingBuffer<char>& ring, bool writing) {
+    // refuse a second in-flight operation of the same kind on this ring -
+    // it would target the same segments
+    for (auto const& o : ops)
+        if (o.live && o.ring == &ring && o.writing == writing)
+            return false;
+    unsigned tail = sqTail->load(memory_order_relaxed); // only we submit
+    if (tail - sqHead->load(memory_order_acquire) >= sqEntries)
+        return false; // submission queue full
+    // find a free op record
+    size_t slot = 0;
+    while (slot < ops.size() && ops[slot].live)
+        ++slot;
+    if (slot == ops.size())
+        return false;
+    op& o = ops[slot];
+    int iovcnt;
+    if (writing) {
+        auto segs = ring.peek();
+        if (segs.first.count == 0)
+            return false; // nothing to send
+        // iovec wants void*, and the kernel only reads from these
+        o.iov[0] = { const_cast<char*>(segs.first.data), segs.first.count };
+        o.iov[1] = { const_cast<char*>(segs.second.data), segs.second.count };
+        iovcnt = segs.second.count ? 2 : 1;
+    } else {
+        auto segs = ring.claim((size_t)-1); // everything that fits
+        if (segs.first.count == 0)
+            return false; // no room
+        o.iov[0] = { segs.first.data, segs.first.count };
+        o.iov[1] = { segs.second.data, segs.second.count };
+        iovcnt = segs.second.count ? 2 : 1;
+    }
+    o.ring = &ring;
+    o.writing = writing;
+    o.live = true;
+    // one sqe, addressed by the op slot through user_data
+    io_uring_sqe& sqe = sqes[tail & sqMask];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = writing ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe.fd = fd;
+    sqe.addr = (uint64_t)(uintptr_t)o.iov;
+    sqe.len = iovcnt;
+    sqe.user_data = slot;
+    sqArray[tail & sqMask] = tail & sqMask;
+    sqTail->store(tail + 1, memory_order_release); // hand it to the kernel
+    ++pendingSubmit;
+    return true;
+}
+
+inline bool UringPump::submit_read(int fd, RingBuffer<char>& ring) {
+    return queue_op(fd, ring, false);
+}
+
+inline bool UringPump::submit_write(int fd, RingBuffer<char>& ring) {
+    return queue_op(fd, ring, true);
+}
+
+// one io_uring_enter for everything queued, then walk the completion ring:
+// a finished read publishes the received bytes into its ring, a finished
+// write consumes the sent ones
+inline int UringPump::pump(unsigned min_complete) {
+    if (pendingSubmit > 0 || min_complete > 0) {
+        unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int r = (int)syscall(__NR_io_uring_enter, ring_fd, pendingSubmit,
+                             min_complete, flags, nullptr, 0);
+        if (r >= 0)
+            pendingSubmit = 0;
+    }
+    int reaped = 0;
+    unsigned head = cqHead->load(memory_order_relaxed); // only we reap
+    while (head != cqTail->load(memory_order_acquire)) {
+        io_uring_cqe const& cqe = cqes[head & cqMask];
+        op& o = ops[cqe.user_data];
+        if (cqe.res > 0) {
+            if (o.writing)
+                o.ring->consume(cqe.res); // the bytes left the ring
+            else
+                o.ring->publish(cqe.res); // the bytes are now readable
+        }
+        o.live = false;
+        ++head;
+        ++reaped;
+    }
+    cqHead->store(head, memory_order_release); // hand the cqes back
+    return reaped;
+}
+
+// A sharded engine for workloads that outgrow one pair of cursors no matter
+// how good the atomics are: an array of SPSC rings, one per producer thread.
+// Each producer is assigned its own shard the first time it produces, so the
+// single-producer contract holds per shard with no claim CAS at all, and
+// consumers round-robin across shards, stealing from whichever has work.
+// Consumers take a shard's busy flag before touching it, so any number of
+// consumer threads can steal without violating the shards' single-consumer
+// contract. The facade is the familiar put()/get() pair.
+template<class T, class Wrap = modulo_wrap>
+class ShardedRingBuffer {
+public:
+    // shardCount must be at least the number of threads that will produce
+    // concurrently; a producer beyond that wraps onto an occupied shard and
+    // the SPSC contract breaks
+    ShardedRingBuffer(size_t capacityPerShard, size_t shardCount);
+    // insertion into the calling thread's own shard
+    bool put(T const&);
+    // removal from whichever shard has work, starting after wherever the
+    // last consumer looked
+    bool get(T& out);
+    // size
+    size_t size() const;
+    bool empty() const;
+    size_t shard_count() const { return rings.size(); }
+private:
+    // a shard: its ring plus the flag consumers take before touching it
+    struct shard {
+        SPSCRingBuffer<T, Wrap> ring;
+        atomic_flag busy = ATOMIC_FLAG_INIT;
+        shard(size_t capacity) : ring(capacity) {}
+    };
+    // the calling thread's shard index: handed out by THIS engine's counter
+    // the first time the thread produces here, so the first shardCount
+    // distinct producers land on distinct shards
+    size_t producer_shard() const;
+private:
+    vector<unique_ptr<shard>> rings; // shards are pinned in memory
+    // hands out producer registrations for this engine
+    mutable atomic<size_t> nextProducer{0};
+    // where the next consumer starts scanning; bumping it spreads concurrent
+    // consumers across different shards instead of having them fight over
+    // shard 0
+    alignas(cache_line) mutable atomic<size_t> scan{0};
+};
+
+template<class T, class Wrap>
+ShardedRingBuffer<T, Wrap>::ShardedRingBuffer(size_t capacityPerShard, size_t shardCount) {
+    rings.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; ++i)
+        rings.push_back(make_unique<shard>(capacityPerShard));
+}
+
+// one fetch_add per thread per engine, then a cached thread_local answer.
+// The cache remembers the last engine this thread produced into; a thread
+// that alternates between engines re-registers on each switch, which burns
+// shard slots - give such threads their own engines instead
+template<class T, class Wrap>
+size_t ShardedRingBuffer<T, Wrap>::producer_shard() const {
+    thread_local void const* lastEngine = nullptr;
+    thread_local size_t lastIdx = 0;
+    if (lastEngine != this) {
+        lastIdx = nextProducer.fetch_add(1, memory_order_relaxed);
+        lastEngine = this;
+    }
+    return lastIdx % rings.size();
+}
+
+// put is an uncontended SPSC put into the caller's own shard
+template<class T, class Wrap>
+bool ShardedRingBuffer<T, Wrap>::put(T const& value) {
+    return rings[producer_shard()]->ring.put(value);
+}
+
+// get scans the shards once, starting one past where the previous consumer
+// started, and takes the first element it can steal
+template<class T, class Wrap>
+bool ShardedRingBuffer<T, Wrap>::get(T& out) {
+    size_t n = rings.size();
+    size_t start = scan.fetch_add(1, memory_order_relaxed);
+    for (size_t i = 0; i < n; ++i) {
+        shard& s = *rings[(start + i) % n];
+        // skip shards another consumer is already draining
+        if (s.busy.test_and_set(memory_order_acquire))
+            continue;
+        bool got = s.ring.get(out);
+        s.busy.clear(memory_order_release);
+        if (got)
+            return true;
+    }
+    return false; // every shard empty (or momentarily busy)
+}
+
+// occupancy summed over the shards; a snapshot only
+template<class T, class Wrap>
+size_t ShardedRingBuffer<T, Wrap>::size() const {
+    size_t total = 0;
+    for (auto const& s : rings)
+        total += s->ring.size();
+    return total;
+}
+
+template<class T, class Wrap>
+bool ShardedRingBuffer<T, Wrap>::empty() const {
+    return size() == 0;
+}
+
+// A message-oriented layer over byte-ring storage for variable-size records:
+// put_msg() writes a 32-bit length prefix plus the payload, so nothing is
+// padded to a worst-case record size and no side ring of lengths is needed.
+// peek_msg() hands the next payload back as a zero-copy view (at most two
+// segments, since it may straddle the wrap) and pop_msg() retires it;
+// get_msg() is the copying convenience on top. Single producer, single
+// consumer thread of control, like the underlying byte ring.
+class MessageRingBuffer {
+public:
+    // capacity is in bytes of storage, prefixes included
+    MessageRingBuffer(size_t capacityBytes) : bytes(capacityBytes) {}
+    // writes one length-prefixed message; false when prefix + payload do not
+    // fit whole (a message is never split across puts)
+    bool put_msg(void const* data, size_t len);
+    // zero-copy view of the next payload; two empty segments when there is
+    // no complete message
+    pair<ring_segment<char const>, ring_segment<char const>> peek_msg() const;
+    // retires the message previously looked at with peek_msg()
+    void pop_msg();
+    // copy-out convenience: copies up to max bytes of the next message into
+    // out, retires it, and returns the message's full length (0 when empty)
+    size_t get_msg(void* out, size_t max);
+    // size
+    size_t size_bytes() const { return bytes.size(); }
+    bool empty() const { return bytes.empty(); }
+private:
+    // reads the length prefix, which may itself straddle the wrap point
+    uint32_t next_len() const;
+private:
+    // the storage is just a byte ring; the framing lives in this class
+    RingBuffer<char> bytes;
+};
+
+// the prefix is written byte-wise through put_bulk like the payload, so the
+// wrap point can fall anywhere, including inside the prefix
+inline bool MessageRingBuffer::put_msg(void const* data, size_t len) {
+    uint32_t prefix = (uint32_t)len;
+    auto segs = bytes.claim(sizeof(prefix) + len);
+    if (segs.first.count + segs.second.count < sizeof(prefix) + len)
+        return false; // does not fit whole
+    bytes.put_bulk(reinterpret_cast<char const*>(&prefix), sizeof(prefix));
+    bytes.put_bulk(reinterpret_cast<char const*>(data), len);
+    return true;
+}
+
+// assembles the prefix from the readable region without consuming it
+inline uint32_t MessageRingBuffer::next_len() const {
+    auto segs = bytes.peek();
+    uint32_t prefix = 0;
+    char* p = reinterpret_cast<char*>(&prefix);
+    for (size_t i = 0; i < sizeof(prefix); ++i)
+        p[i] = i < segs.first.count ? segs.first.data[i]
+                                    : segs.second.data[i - segs.first.count];
+    return prefix;
+}
+
+// the payload view: the readable region minus the prefix, clipped to the
+// message length - still at most two segments
+inline auto MessageRingBuffer::peek_msg() const
+    -> pair<ring_segment<char const>, ring_segment<char const>> {
+    if (bytes.size() < sizeof(uint32_t))
+        return {};
+    uint32_t len = next_len();
+    auto segs = bytes.peek();
+    // skip the prefix
+    size_t skip = sizeof(uint32_t);
+    if (skip >= segs.first.count) {
+        segs.second.data += skip - segs.first.count;
+        segs.second.count -= skip - segs.first.count;
+        segs.first = {};
+    } else {
+        segs.first.data += skip;
+        segs.first.count -= skip;
+    }
+    // clip to the message length
+    if (segs.first.count >= len) {
+        segs.first.count = len;
+        segs.second = {};
+    } else {
+        segs.second.count = len - segs.first.count;
+    }
+    // a second message may start in the second segment; never expose it
+    return segs;
+}
+
+// retiring a message is one consume over prefix + payload
+inline void MessageRingBuffer::pop_msg() {
+    if (bytes.size() < sizeof(uint32_t))
+        return;
+    bytes.consume(sizeof(uint32_t) + next_len());
+}
+
+inline size_t MessageRingBuffer::get_msg(void* out, size_t max) {
+    auto segs = peek_msg();
+    size_t len = segs.first.count + segs.second.count;
+    if (bytes.size() < sizeof(uint32_t))
+        return 0;
+    size_t n = len < max ? len : max;
+    size_t first = segs.first.count < n ? segs.first.count : n;
+    if (first)
+        memcpy(out, segs.first.data, first);
+    if (n - first)
+        memcpy(reinterpret_cast<char*>(out) + first, segs.second.data, n - first);
+    pop_msg();
+    return len;
 }
@@ -0,0 +1,109 @@
+// Benchmarks for the ring buffer variants, built on Google Benchmark.
+// Build and run with: make bench
+// Useful while chasing a single number: ./RingBufferBench --benchmark_filter=...
+#include "RingBuffer.cpp"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+// payload sizes spanning a machine word, a cache line, and a network frame
+struct sample4 { char bytes[4]; };
+struct sample64 { char bytes[64]; };
+struct sample2k { char bytes[2048]; };
+
+// single-element put/get round trip through the plain ring; the capacity
+// range walks the working set from L1-resident up into DRAM
+template<class T, class Wrap>
+static void BM_PutGet(benchmark::State& state) {
+    RingBuffer<T, Wrap> ring(state.range(0));
+    T value{};
+    for (auto _ : state) {
+        ring.put(value);
+        benchmark::DoNotOptimize(ring.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * sizeof(T));
+}
+BENCHMARK_TEMPLATE(BM_PutGet, sample4, modulo_wrap)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_PutGet, sample4, mask_wrap)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_PutGet, sample64, modulo_wrap)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_PutGet, sample64, mask_wrap)->Range(1 << 10, 1 << 18);
+BENCHMARK_TEMPLATE(BM_PutGet, sample2k, modulo_wrap)->Range(1 << 8, 1 << 14);
+BENCHMARK_TEMPLATE(BM_PutGet, sample2k, mask_wrap)->Range(1 << 8, 1 << 14);
+
+// bulk transfer in the batch sizes the packet path actually uses
+template<class T>
+static void BM_Bulk(benchmark::State& state) {
+    size_t batch = state.range(0);
+    RingBuffer<T> ring(batch * 2);
+    std::vector<T> in(batch), out(batch);
+    for (auto _ : state) {
+        ring.put_bulk(in.data(), batch);
+        ring.get_bulk(out.data(), batch);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+    state.SetBytesProcessed(state.iterations() * batch * sizeof(T));
+}
+BENCHMARK_TEMPLATE(BM_Bulk, sample4)->Arg(64)->Arg(512);
+BENCHMARK_TEMPLATE(BM_Bulk, sample64)->Arg(64)->Arg(512);
+BENCHMARK_TEMPLATE(BM_Bulk, sample2k)->Arg(64)->Arg(512);
+
+// the same batch through the zero-copy path for comparison
+template<class T>
+static void BM_PeekConsume(benchmark::State& state) {
+    size_t batch = state.range(0);
+    RingBuffer<T> ring(batch * 2);
+    std::vector<T> in(batch);
+    for (auto _ : state) {
+        ring.put_bulk(in.data(), batch);
+        auto segs = ring.peek();
+        benchmark::DoNotOptimize(segs.first.data);
+        ring.consume(batch);
+    }
+    state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK_TEMPLATE(BM_PeekConsume, sample2k)->Arg(64)->Arg(512);
+
+// iterator traversal: this is where the % cycle vs & mask difference lives
+template<class Wrap>
+static void BM_Iterate(benchmark::State& state) {
+    RingBuffer<int, Wrap> ring(state.range(0));
+    for (int i = 0; i < state.range(0); ++i)
+        ring.put(i);
+    for (auto _ : state) {
+        long long sum = 0;
+        for (auto it = ring.begin(); it != ring.end(); ++it)
+            sum += *it;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_Iterate, modulo_wrap)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_Iterate, mask_wrap)->Range(1 << 10, 1 << 22);
+
+// mixed producer/consumer throughput on the concurrent rings. Run with an
+// even thread count: even thread indices produce, odd ones consume, and the
+// per-thread iteration counts balance out.
+template<class Ring>
+static void BM_ProducerConsumer(benchmark::State& state) {
+    static Ring ring(1 << 14); // magic static: constructed once, raced safely
+    if (state.thread_index() % 2 == 0) {
+        for (auto _ : state) {
+            while (!ring.put(1))
+                ;
+        }
+    } else {
+        int v;
+        for (auto _ : state) {
+            while (!ring.get(v))
+                ;
+            benchmark::DoNotOptimize(v);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, SPSCRingBuffer<int>)->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, MPMCRingBuffer<int>)->Threads(2)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, MPMCRingBuffer<int>)->Threads(8)->UseRealTime();
+
+BENCHMARK_MAIN();